@@ -12,6 +12,19 @@
 #include "bsp.h"
 #include "buttons.h"
 
+/**
+  * @defgroup Boolean true and flase definitions
+  @{ */
+#ifndef FALSE
+#define FALSE 0u /*!< FALSE definition */
+#endif
+
+#ifndef TRUE
+#define TRUE 1u /*!< TRUE definition */
+#endif
+/**
+  @} */
+
 /**
  * @brief   States of the button state machine
  */
@@ -23,12 +36,58 @@ typedef enum _ButtonStates
     ST_RELEASE      /*!< Release state*/
 } ButtonStates;
 
+#ifdef BUTTONS_EVENTS
+/**
+ * @brief   Double click detection states
+ */
+typedef enum _ClickStates
+{
+    CLICK_NONE = 0, /*!< No click to pair with*/
+    CLICK_ARMED,    /*!< A click was released, the next press can be a double click*/
+    CLICK_DOUBLE    /*!< The current press is the second click*/
+} ClickStates;
+#endif
+
+/**
+  * @defgroup Buttons_fields Access to the port, pin and active level of a button, in compact mode
+  * the port and pin are packed in one byte and the level is in the mask of the port
+  @{ */
+#ifdef BUTTONS_COMPACT
+#define BUTTON_PIN( Buttons, Btn )    ( (uint8_t)( (Buttons)->BtnBuffer[Btn].PortPin & 0x0Fu ) )
+#define BUTTON_PORT( Buttons, Btn )   ( (uint8_t)( (Buttons)->BtnBuffer[Btn].PortPin >> 4u ) )
+#define BUTTON_LEVEL( Buttons, Btn )  ( (uint8_t)( ( (Buttons)->Ports[BUTTON_PORT( Buttons, Btn )].Level >> BUTTON_PIN( Buttons, Btn ) ) & 1u ) )
+#else
+#define BUTTON_PIN( Buttons, Btn )    ( (Buttons)->BtnBuffer[Btn].Pin )
+#define BUTTON_PORT( Buttons, Btn )   ( (Buttons)->BtnBuffer[Btn].Port )
+#define BUTTON_LEVEL( Buttons, Btn )  ( (Buttons)->BtnBuffer[Btn].ActiveLevel )
+#endif
+/**
+  @} */
+
 /**
  * @brief   Array of GPIO ports from the STM32G0xx family
  */
 static GPIO_TypeDef *Ports[] = { GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOF };
 
-static void Sample_Button( ButtonType *Button, uint8_t Samples );
+static void Sample_Buttons( KeyboardType *Buttons );
+#ifdef BUTTONS_VERTICAL
+#ifdef BUTTONS_EVENTS
+static void Sample_Events( KeyboardType *Buttons, uint8_t Port, uint16_t Changed );
+#endif
+#else
+static void Sample_Button( KeyboardType *Buttons, uint8_t Btn );
+#endif
+#ifdef BUTTONS_EVENTS
+static void Button_Press( KeyboardType *Buttons, uint8_t Btn );
+static void Button_Hold( KeyboardType *Buttons, uint8_t Btn );
+static void Button_Release( KeyboardType *Buttons, uint8_t Btn );
+static void Button_Notify( KeyboardType *Buttons, uint8_t Btn, uint8_t Event );
+#endif
+#ifdef BUTTONS_WAKEUP
+static void Buttons_Sleep( KeyboardType *Buttons );
+static uint8_t Buttons_Idle( const KeyboardType *Buttons );
+static uint8_t Buttons_Active( const KeyboardType *Buttons );
+#endif
 
 /**
  * @brief   Initialize the button handler
@@ -38,7 +97,9 @@ static void Sample_Button( ButtonType *Button, uint8_t Samples );
  * 
  * @param Buttons Pointer to the KeyboardType structure
  * @param NButtons Number of buttons to handle
- * @param Samples Number of samples to detect an activation
+ * @param Samples Number of samples to detect an activation, with BUTTONS_VERTICAL a change is
+ *        reported after Samples scans, without it after Samples + 1 since the first scan that
+ *        sees the change only starts the count
  * @param Buffer Pointer to the buffer array to store the buttons structure
  * 
  * @return void
@@ -49,6 +110,36 @@ void Buttons_Init( KeyboardType *Buttons, uint8_t NButtons, uint8_t Samples, But
     Buttons->Sample = Samples;
     Buttons->BtnBuffer = Buffer;
     Buttons->Counter = 0;
+#ifdef BUTTONS_WAKEUP
+    Buttons->Sleeping = FALSE;
+#endif
+#ifdef BUTTONS_EVENTS
+    Buttons->Events = NULL;
+    Buttons->LongPress = 0;
+    Buttons->DoubleClick = 0;
+    Buttons->Repeat = 0;
+#endif
+#ifdef BUTTONS_VERTICAL
+    /*a change shall last at least one sample*/
+    Buttons->Sample = ( Samples == 0u ) ? 1u : Samples;
+#if BUTTONS_VERTICAL_BITS < 8u
+    /*the counters can not go beyond its bits*/
+    if( Buttons->Sample > ( ( 1u << BUTTONS_VERTICAL_BITS ) - 1u ) )
+    {
+        Buttons->Sample = (uint8_t)( ( 1u << BUTTONS_VERTICAL_BITS ) - 1u );
+    }
+#endif
+    /*only the counter bits needed to reach the number of samples are computed*/
+    Buttons->Bits = 0;
+    while( ( Buttons->Bits < BUTTONS_VERTICAL_BITS ) && ( ( Buttons->Sample >> Buttons->Bits ) != 0u ) )
+    {
+        Buttons->Bits++;
+    }
+    for( uint8_t port = 0; port < BUTTONS_PORTS; port++ )
+    {
+        Buttons->Ports[port] = (ButtonsPortType){ 0 };
+    }
+#endif
 }
 
 /**
@@ -57,24 +148,37 @@ void Buttons_Init( KeyboardType *Buttons, uint8_t NButtons, uint8_t Samples, But
  * This function registers a button in the button handler. The button is defined by the pin, port and the active level.
  * 
  * @param Buttons Pointer to the KeyboardType structure
- * @param Pin Pin where the button is connected
- * @param Port Port where the pin is connected
+ * @param Pin Pin where the button is connected, from 0 to 15
+ * @param Port Port where the pin is connected, lower than BUTTONS_PORTS
  * @param ActiveLevel Active level of the button
  * 
- * @return uint8_t The button number
+ * @return uint8_t The button number, zero if there is no room or the port or pin is not valid
  */
 uint8_t Buttons_Register( KeyboardType *Buttons, uint8_t Pin, uint8_t Port, uint8_t ActiveLevel )
 {
     uint8_t result = 0;
 
-    if( Buttons->Counter < Buttons->Buttons )
+    if( ( Buttons->Counter < Buttons->Buttons ) && ( Port < BUTTONS_PORTS ) && ( Pin < 16u ) )
     {
+#ifdef BUTTONS_COMPACT
+        Buttons->BtnBuffer[Buttons->Counter].PortPin = (uint8_t)( ( Port << 4u ) | ( Pin & 0x0Fu ) );
+#else
         Buttons->BtnBuffer[Buttons->Counter].Pin = Pin;
         Buttons->BtnBuffer[Buttons->Counter].Port = Port;
         Buttons->BtnBuffer[Buttons->Counter].ActiveLevel = ActiveLevel;
         Buttons->BtnBuffer[Buttons->Counter].Status = BTN_INACTIVE;
         Buttons->BtnBuffer[Buttons->Counter].Event = BTN_IDLE;
         Buttons->BtnBuffer[Buttons->Counter].smState = ST_IDLE;
+#endif
+#ifdef BUTTONS_EVENTS
+        Buttons->BtnBuffer[Buttons->Counter].Long = FALSE;
+        Buttons->BtnBuffer[Buttons->Counter].Click = CLICK_NONE;
+#endif
+#ifdef BUTTONS_VERTICAL
+        /*the pin is debounced along with the other pins of its port*/
+        Buttons->Ports[Port].Mask |= (uint16_t)( 1u << Pin );
+        Buttons->Ports[Port].Level |= (uint16_t)( ( ActiveLevel != 0u ) ? ( 1u << Pin ) : 0u );
+#endif
         Buttons->Counter++;
         result = Buttons->Counter;
     }
@@ -97,9 +201,13 @@ uint8_t Buttons_GetStatus( KeyboardType *Buttons, uint8_t Button )
 {
     uint8_t result = BTN_INACTIVE;
 
-    if( Button < Buttons->Counter )
+    if( ( Button > 0u ) && ( Button <= Buttons->Counter ) )
     {
+#ifdef BUTTONS_VERTICAL
+        result = ( ( Buttons->Ports[BUTTON_PORT( Buttons, Button - 1 )].Status >> BUTTON_PIN( Buttons, Button - 1 ) ) & 1u );
+#else
         result = Buttons->BtnBuffer[Button - 1].Status;
+#endif
     }
 
     return result;
@@ -109,7 +217,8 @@ uint8_t Buttons_GetStatus( KeyboardType *Buttons, uint8_t Button )
  * @brief   Get the event of a button
  * 
  * This function returns the event of a button, PRESSED or RELEASED. After this fucntion is called
- * the event is cleared.
+ * the event is cleared. The long press, double click and repeat are only written into the events
+ * queue, so the function works the same with BUTTONS_VERTICAL or without it.
  * 
  * @param Buttons Pointer to the KeyboardType structure
  * @param Button Button number
@@ -120,44 +229,477 @@ uint8_t Buttons_GetEvent( KeyboardType *Buttons, uint8_t Button )
 {
     uint8_t result = BTN_IDLE;
 
-    if( Button <= Buttons->Counter )
+    if( ( Button > 0u ) && ( Button <= Buttons->Counter ) )
     {
+#ifdef BUTTONS_VERTICAL
+        ButtonsPortType *port = &Buttons->Ports[BUTTON_PORT( Buttons, Button - 1 )];
+        uint16_t pin = (uint16_t)( 1u << BUTTON_PIN( Buttons, Button - 1 ) );
+
+        if( ( port->Pressed & pin ) != 0u )
+        {
+            result = BTN_PRESSED;
+        }
+        else if( ( port->Released & pin ) != 0u )
+        {
+            result = BTN_RELEASED;
+        }
+        else
+        {
+            /*no event*/
+        }
+        port->Pressed &= (uint16_t)~pin;
+        port->Released &= (uint16_t)~pin;
+#else
         result = Buttons->BtnBuffer[Button - 1].Event;
         Buttons->BtnBuffer[Button - 1].Event = BTN_IDLE;
+#endif
     }
     
     return result;
 }
 
+/**
+ * @brief   Get the status of all the buttons of a port
+ * 
+ * This function returns the status of the buttons registered on a port as a mask, one bit per pin
+ * set when the button is active, with BUTTONS_VERTICAL it is a single read of the port status.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Port Port to read, the same number used to register the buttons
+ * 
+ * @return uint16_t The status of the buttons of the port, zero for a port not valid
+ */
+uint16_t Buttons_GetStatusMask( KeyboardType *Buttons, uint8_t Port )
+{
+    uint16_t result = 0;
+
+    if( Port < BUTTONS_PORTS )
+    {
+#ifdef BUTTONS_VERTICAL
+        result = Buttons->Ports[Port].Status;
+#else
+        for( uint8_t btn = 0; btn < Buttons->Counter; btn++ )
+        {
+            if( ( Buttons->BtnBuffer[btn].Port == Port ) && ( Buttons->BtnBuffer[btn].Status == BTN_ACTIVE ) )
+            {
+                result |= (uint16_t)( 1u << Buttons->BtnBuffer[btn].Pin );
+            }
+        }
+#endif
+    }
+
+    return result;
+}
+
+#ifdef BUTTONS_EVENTS
+/**
+ * @brief   Set the queue for the buttons events
+ * 
+ * This function sets the queue where each event is written along with the button number and the
+ * tick when it was detected, so the events can be read later at any rate without losing any of
+ * them, the queue shall be initialized with elements of ButtonEventType size.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Queue Pointer to the queue, NULL to stop writing events
+ * 
+ * @return uint8_t TRUE if the queue was set, FALSE if its elements are not ButtonEventType
+ */
+uint8_t Buttons_SetQueue( KeyboardType *Buttons, QueueType *Queue )
+{
+    uint8_t result = FALSE;
+
+    if( ( Queue == NULL ) || ( Queue->Size == sizeof( ButtonEventType ) ) )
+    {
+        Buttons->Events = Queue;
+        result = TRUE;
+    }
+
+    return result;
+}
+
+/**
+ * @brief   Set the times of the buttons gestures
+ * 
+ * This function sets the times in milliseconds for the long press, the double click and the
+ * repeat events, a zero time disables the event, the repeat starts after the long press.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param LongPress Time the button shall be held to send a long press
+ * @param DoubleClick Maximum time from the release of a click to the next press for a double click
+ * @param Repeat Time between repeats while the button is held after a long press
+ * 
+ * @return void
+ */
+void Buttons_SetTimes( KeyboardType *Buttons, uint16_t LongPress, uint16_t DoubleClick, uint16_t Repeat )
+{
+    Buttons->LongPress = LongPress;
+    Buttons->DoubleClick = DoubleClick;
+    Buttons->Repeat = Repeat;
+}
+#endif
+
+/**
+ * @brief   Debounce all the pins of a port
+ * 
+ * Each pin has a counter of the samples read different from its debounced status, the counters
+ * are stored vertically, the word n holds the bit n of the counter of each pin, so incrementing
+ * all of them is a ripple of AND and XOR operations over the words. A pin that reads the same as
+ * its status restarts its counter, and when the counter reaches the number of samples the status
+ * of the pin toggles and a press or release event is stored. It is used by the vertical mode
+ * and by the keypad module for each row of the matrix.
+ * 
+ * @param Port Pointer to the ButtonsPortType structure
+ * @param Input Value read from the port input register, or any other 16 inputs
+ * @param Samples Number of samples to detect an activation
+ * @param Bits Number of counter bits needed to count up to Samples
+ * 
+ * @return uint16_t The pins that toggled its status on this sample
+ */
+uint16_t Buttons_Debounce( ButtonsPortType *Port, uint16_t Input, uint8_t Samples, uint8_t Bits )
+{
+    /*pins active according to its own level*/
+    uint16_t active = (uint16_t)~( Input ^ Port->Level ) & Port->Mask;
+    /*pins that read different from its debounced status*/
+    uint16_t delta = active ^ Port->Status;
+    uint16_t carry = delta;
+    uint16_t match = delta;
+    uint16_t count;
+    uint16_t expected;
+
+    for( uint8_t bit = 0; bit < Bits; bit++ )
+    {
+        /*restart the pins with no change and increment the rest*/
+        count = Port->Count[bit] & delta;
+        Port->Count[bit] = count ^ carry;
+        carry &= count;
+        /*compare against the bit of the number of samples*/
+        expected = (uint16_t)( 0u - ( ( (uint16_t)Samples >> bit ) & 1u ) );
+        match &= (uint16_t)~( Port->Count[bit] ^ expected );
+    }
+
+    if( match != 0u )
+    {
+        /*the pins that reach the number of samples toggle its status*/
+        Port->Status ^= match;
+        Port->Pressed = ( Port->Pressed | ( match & Port->Status ) ) & (uint16_t)~( match & ~Port->Status );
+        Port->Released = ( Port->Released | ( match & ~Port->Status ) ) & (uint16_t)~( match & Port->Status );
+        for( uint8_t bit = 0; bit < Bits; bit++ )
+        {
+            Port->Count[bit] &= (uint16_t)~match;
+        }
+    }
+
+    return match;
+}
+
 /**
  * @brief   Main function for the button handler
  * 
  * This function is the main function for the button handler. It samples the buttons and stores the status
- * and events in the buffer.
+ * and events in the buffer. With BUTTONS_VERTICAL each port with buttons is read once and all its
+ * pins are sampled together. With BUTTONS_WAKEUP nothing is sampled while sleeping and once all
+ * the buttons are back to idle the EXTI lines are armed and the sampling stops.
  * 
  * @param Buttons Pointer to the KeyboardType structure
  */
 void Buttons_MainFunction( KeyboardType *Buttons )
 {
+#ifdef BUTTONS_WAKEUP
+    /*nothing to sample until an edge wakes up the buttons*/
+    if( Buttons->Sleeping == FALSE )
+    {
+        Sample_Buttons( Buttons );
+        Buttons_Sleep( Buttons );
+    }
+#else
+    Sample_Buttons( Buttons );
+#endif
+}
+
+/**
+ * @brief   Sample all the buttons once
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * 
+ * @return void
+ */
+static void Sample_Buttons( KeyboardType *Buttons )
+{
+#ifdef BUTTONS_VERTICAL
+    uint16_t changed;
+#endif
+#ifdef BUTTONS_EVENTS
+    /*all the events of the same scan get the same time stamp*/
+    Buttons->Now = HAL_GetTick( );
+#endif
+#ifdef BUTTONS_VERTICAL
+    for( uint8_t port = 0; port < BUTTONS_PORTS; port++ )
+    {
+        if( Buttons->Ports[port].Mask != 0u )
+        {
+            /*sample all the pins of the port at once*/
+            changed = Buttons_Debounce( &Buttons->Ports[port], (uint16_t)Ports[port]->IDR, Buttons->Sample, Buttons->Bits );
+#ifdef BUTTONS_EVENTS
+            /*the buttons are only visited while something happens on its port*/
+            if( ( changed | Buttons->Ports[port].Status ) != 0u )
+            {
+                Sample_Events( Buttons, port, changed );
+            }
+#else
+            (void)changed;
+#endif
+        }
+    }
+#else
     for( uint8_t btn = 0; btn < Buttons->Counter; btn++ )
     {
         /*sample one single button*/
-        Sample_Button( &Buttons->BtnBuffer[btn], Buttons->Sample );
+        Sample_Button( Buttons, btn );
     }
+#endif
 }
 
+#ifdef BUTTONS_WAKEUP
+/**
+ * @brief   Wake up the button handler
+ * 
+ * This function disarms the EXTI lines and resumes the sampling, it shall be called from the EXTI
+ * interrupt of the buttons pins, calling it while the handler is not sleeping has no effect.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * 
+ * @return void
+ */
+void Buttons_Wakeup( KeyboardType *Buttons )
+{
+    if( Buttons->Sleeping == TRUE )
+    {
+        Buttons_WakeupHook( Buttons, FALSE );
+        Buttons->Sleeping = FALSE;
+    }
+}
+
+/**
+ * @brief   Ask if the button handler is sleeping
+ * 
+ * This function returns TRUE when all the buttons are idle and the sampling is stopped waiting
+ * for an edge, the task calling Buttons_MainFunction can be stopped until Buttons_Wakeup is called.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * 
+ * @return uint8_t TRUE if the sampling is stopped, FALSE otherwise
+ */
+uint8_t Buttons_IsSleeping( const KeyboardType *Buttons )
+{
+    return Buttons->Sleeping;
+}
+
+/**
+ * @brief   Arm or disarm the EXTI lines of the buttons
+ * 
+ * The default implementation is for the STM32G0xx EXTI, each registered pin selects its port on
+ * the EXTI line with the same number and is armed on the edge that goes to its active level, the
+ * interrupts shall be enabled on the NVIC by the application. Each button needs a different pin
+ * number since the ports share the lines, otherwise the application shall provide its own
+ * function, for instance to use a single line or another microcontroller.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Enable TRUE to arm the lines, FALSE to disarm them and clear its pending flags
+ * 
+ * @return void
+ */
+__weak void Buttons_WakeupHook( KeyboardType *Buttons, uint8_t Enable )
+{
+    uint32_t lines = 0;
+    uint32_t rising = 0;
+    uint8_t pin;
+
+    for( uint8_t btn = 0; btn < Buttons->Counter; btn++ )
+    {
+        pin = BUTTON_PIN( Buttons, btn );
+        lines |= ( 1ul << pin );
+        if( Enable == TRUE )
+        {
+            /*select the port of the pin on its line*/
+            EXTI->EXTICR[pin >> 2u] &= ~( 0xFFul << ( ( pin & 3u ) * 8u ) );
+            EXTI->EXTICR[pin >> 2u] |= ( (uint32_t)BUTTON_PORT( Buttons, btn ) << ( ( pin & 3u ) * 8u ) );
+            rising |= ( BUTTON_LEVEL( Buttons, btn ) != 0u ) ? ( 1ul << pin ) : 0u;
+        }
+    }
+
+    if( Enable == TRUE )
+    {
+        EXTI->RTSR1 = ( EXTI->RTSR1 & ~lines ) | rising;
+        EXTI->FTSR1 = ( EXTI->FTSR1 & ~lines ) | ( lines & ~rising );
+        EXTI->IMR1 |= lines;
+    }
+    else
+    {
+        EXTI->IMR1 &= ~lines;
+        EXTI->RPR1 = lines;
+        EXTI->FPR1 = lines;
+    }
+}
+
+/**
+ * @brief   Stop the sampling when all the buttons are idle
+ * 
+ * The sleeping flag is set before arming the lines so an edge right after still clears it, and the
+ * pins are read once armed since a press between the last sample and the arming left no edge.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * 
+ * @return void
+ */
+static void Buttons_Sleep( KeyboardType *Buttons )
+{
+    if( ( Buttons->Counter > 0u ) && ( Buttons_Idle( Buttons ) == TRUE ) )
+    {
+        Buttons->Sleeping = TRUE;
+        Buttons_WakeupHook( Buttons, TRUE );
+        if( Buttons_Active( Buttons ) == TRUE )
+        {
+            Buttons_Wakeup( Buttons );
+        }
+    }
+}
+
+/**
+ * @brief   Ask if all the buttons are idle
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * 
+ * @return uint8_t TRUE if no button is pressed or debouncing, FALSE otherwise
+ */
+static uint8_t Buttons_Idle( const KeyboardType *Buttons )
+{
+    uint8_t result = TRUE;
+
+#ifdef BUTTONS_VERTICAL
+    for( uint8_t port = 0; port < BUTTONS_PORTS; port++ )
+    {
+        /*a counter different than zero is a change being debounced*/
+        uint16_t busy = Buttons->Ports[port].Status;
+        for( uint8_t bit = 0; bit < Buttons->Bits; bit++ )
+        {
+            busy |= Buttons->Ports[port].Count[bit];
+        }
+        if( busy != 0u )
+        {
+            result = FALSE;
+        }
+    }
+#else
+    for( uint8_t btn = 0; btn < Buttons->Counter; btn++ )
+    {
+        if( Buttons->BtnBuffer[btn].smState != ST_IDLE )
+        {
+            result = FALSE;
+        }
+    }
+#endif
+
+    return result;
+}
+
+/**
+ * @brief   Ask if any button pin is at its active level
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * 
+ * @return uint8_t TRUE if at least one pin reads active, FALSE otherwise
+ */
+static uint8_t Buttons_Active( const KeyboardType *Buttons )
+{
+    uint8_t result = FALSE;
+
+#ifdef BUTTONS_VERTICAL
+    for( uint8_t port = 0; port < BUTTONS_PORTS; port++ )
+    {
+        const ButtonsPortType *state = &Buttons->Ports[port];
+        if( ( (uint16_t)~( (uint16_t)Ports[port]->IDR ^ state->Level ) & state->Mask ) != 0u )
+        {
+            result = TRUE;
+        }
+    }
+#else
+    for( uint8_t btn = 0; btn < Buttons->Counter; btn++ )
+    {
+        const ButtonType *button = &Buttons->BtnBuffer[btn];
+        if( HAL_GPIO_ReadPin( Ports[button->Port], (1<<button->Pin) ) == button->ActiveLevel )
+        {
+            result = TRUE;
+        }
+    }
+#endif
+
+    return result;
+}
+#endif
+
+#ifdef BUTTONS_VERTICAL
+#ifdef BUTTONS_EVENTS
+/**
+ * @brief   Run the events of the buttons of a port
+ * 
+ * The buttons of the port that toggled its status get its press or release and the ones still
+ * pressed are checked for long press and repeat.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Port Port with buttons that toggled or are pressed
+ * @param Changed Pins that toggled its status on this sample
+ * 
+ * @return void
+ */
+static void Sample_Events( KeyboardType *Buttons, uint8_t Port, uint16_t Changed )
+{
+    uint16_t pin;
+
+    for( uint8_t btn = 0; btn < Buttons->Counter; btn++ )
+    {
+        if( Buttons->BtnBuffer[btn].Port == Port )
+        {
+            pin = (uint16_t)( 1u << Buttons->BtnBuffer[btn].Pin );
+            if( ( Changed & pin ) != 0u )
+            {
+                if( ( Buttons->Ports[Port].Status & pin ) != 0u )
+                {
+                    Button_Press( Buttons, btn );
+                }
+                else
+                {
+                    Button_Release( Buttons, btn );
+                }
+            }
+            else if( ( Buttons->Ports[Port].Status & pin ) != 0u )
+            {
+                Button_Hold( Buttons, btn );
+            }
+            else
+            {
+                /*idle button*/
+            }
+        }
+    }
+}
+#endif
+#else
+
 /**
  * @brief   Sample the button
  * 
  * This function samples the button and stores the status and events in the buffer.
  * 
- * @param Button Pointer to the ButtonType structure
- * @param Samples Number of samples to detect an activation
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Btn Index of the button in the buffer
  * 
  * @return void
  */
-static void Sample_Button( ButtonType *Button, uint8_t Samples )
+static void Sample_Button( KeyboardType *Buttons, uint8_t Btn )
 {   
+    ButtonType *Button = &Buttons->BtnBuffer[Btn];
+    uint8_t Samples = Buttons->Sample;
+
     switch( Button->smState )
     {
         /*ask if the button has been pressed*/
@@ -182,7 +724,11 @@ static void Sample_Button( ButtonType *Button, uint8_t Samples )
           if( Button->Counter >= Samples )
           {
               /*if so, an actual press action is detected*/
+#ifdef BUTTONS_EVENTS
+              Button_Press( Buttons, Btn );
+#else
               Button->Event = BTN_PRESSED;
+#endif
               Button->Status = BTN_ACTIVE;
               Button->smState = ST_HOLD;
           }
@@ -194,6 +740,13 @@ static void Sample_Button( ButtonType *Button, uint8_t Samples )
                 Button->smState = ST_RELEASE;
                 Button->Counter = 0; /*start the counter*/
             }
+#ifdef BUTTONS_EVENTS
+            else
+            {
+                /*still pressed, time for a long press or a repeat*/
+                Button_Hold( Buttons, Btn );
+            }
+#endif
         break;
         case  ST_RELEASE:
             /*increase counter*/
@@ -208,10 +761,122 @@ static void Sample_Button( ButtonType *Button, uint8_t Samples )
             if( Button->Counter >= Samples)
             {
                 /*if so, an actual release action is detected*/
+#ifdef BUTTONS_EVENTS
+                Button_Release( Buttons, Btn );
+#else
                 Button->Event = BTN_RELEASED;
+#endif
                 Button->Status = BTN_INACTIVE;
                 Button->smState = ST_IDLE;
             }
         break;
     }
 }
+#endif
+
+#ifdef BUTTONS_EVENTS
+/**
+ * @brief   Button press detected
+ * 
+ * A press that comes within the double click time after a click also sends a double click, and
+ * the time for the long press starts.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Btn Index of the button in the buffer
+ * 
+ * @return void
+ */
+static void Button_Press( KeyboardType *Buttons, uint8_t Btn )
+{
+    ButtonType *button = &Buttons->BtnBuffer[Btn];
+
+    Button_Notify( Buttons, Btn, BTN_PRESSED );
+    if( ( button->Click == CLICK_ARMED ) && ( ( Buttons->Now - button->Time ) <= Buttons->DoubleClick ) )
+    {
+        Button_Notify( Buttons, Btn, BTN_DOUBLE_CLICK );
+        button->Click = CLICK_DOUBLE; /*a third press starts over*/
+    }
+    else
+    {
+        button->Click = CLICK_NONE;
+    }
+    button->Long = FALSE;
+    button->Time = Buttons->Now + Buttons->LongPress;
+}
+
+/**
+ * @brief   Button still pressed
+ * 
+ * Once the button is held for the long press time a long press is sent, and after that a repeat
+ * each repeat time.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Btn Index of the button in the buffer
+ * 
+ * @return void
+ */
+static void Button_Hold( KeyboardType *Buttons, uint8_t Btn )
+{
+    ButtonType *button = &Buttons->BtnBuffer[Btn];
+
+    if( ( Buttons->LongPress > 0u ) && ( ( button->Long == FALSE ) || ( Buttons->Repeat > 0u ) ) &&
+        ( (int32_t)( Buttons->Now - button->Time ) >= 0 ) )
+    {
+        Button_Notify( Buttons, Btn, ( button->Long == FALSE ) ? BTN_LONG_PRESS : BTN_REPEAT );
+        button->Long = TRUE;
+        button->Time += Buttons->Repeat;
+    }
+}
+
+/**
+ * @brief   Button release detected
+ * 
+ * The release of a short press that was not a double click arms the double click detection.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Btn Index of the button in the buffer
+ * 
+ * @return void
+ */
+static void Button_Release( KeyboardType *Buttons, uint8_t Btn )
+{
+    ButtonType *button = &Buttons->BtnBuffer[Btn];
+
+    Button_Notify( Buttons, Btn, BTN_RELEASED );
+    button->Click = ( ( button->Click == CLICK_NONE ) && ( button->Long == FALSE ) && ( Buttons->DoubleClick > 0u ) ) ? CLICK_ARMED : CLICK_NONE;
+    button->Time = Buttons->Now;
+}
+
+/**
+ * @brief   Store an event of a button
+ * 
+ * The event is written with the time stamp of the scan into the events queue if one was set, an
+ * event is lost if the queue is full. A press or release is also kept as the last event of the
+ * button for Buttons_GetEvent, with BUTTONS_VERTICAL the scan already keeps it in the port masks.
+ * 
+ * @param Buttons Pointer to the KeyboardType structure
+ * @param Btn Index of the button in the buffer
+ * @param Event The event detected
+ * 
+ * @return void
+ */
+static void Button_Notify( KeyboardType *Buttons, uint8_t Btn, uint8_t Event )
+{
+    ButtonEventType event;
+
+#ifndef BUTTONS_VERTICAL
+    /*the gestures are only written into the queue, they shall not overwrite an unread press*/
+    if( ( Event == BTN_PRESSED ) || ( Event == BTN_RELEASED ) )
+    {
+        Buttons->BtnBuffer[Btn].Event = Event;
+    }
+#endif
+    if( Buttons->Events != NULL )
+    {
+        event.Time = Buttons->Now;
+        event.Button = Btn + 1u;
+        event.Event = Event;
+        (void)Queue_WriteData( Buttons->Events, &event );
+    }
+}
+#endif
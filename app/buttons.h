@@ -8,10 +8,78 @@
  * 
  * The code was written for the STM32xx family of microcontrollers, but it can be easily ported
  * to other microcontrollers.  
+ *
+ * Defining BUTTONS_VERTICAL at compile time each port is read once per scan and all its pins are
+ * debounced at the same time with vertical counters, one bit of each counter word per pin, so the
+ * scan cost depends on the number of ports used instead of the number of buttons.
+ *
+ * Defining BUTTONS_WAKEUP at compile time the sampling stops once all the buttons are idle and
+ * the EXTI lines of the pins are armed with Buttons_WakeupHook, the EXTI interrupt calls
+ * Buttons_Wakeup and the sampling goes on until the buttons are idle again. With the scheduler
+ * the buttons task stops itself when Buttons_IsSleeping returns TRUE, and the interrupt notifies
+ * an event task (zero period) that starts it again, so the tickless idle mode can sleep.
+ *
+ * Defining BUTTONS_EVENTS at compile time the buttons also detect long press, double click and
+ * auto-repeat with the times set by Buttons_SetTimes, and every event is written with the button
+ * number and its tick into the queue set with Buttons_SetQueue, so the events can be read at a
+ * low rate without missing a press released before the consumer runs. The gestures are only
+ * delivered through the queue, Buttons_GetEvent keeps returning just the press and release.
+ *
+ * Defining BUTTONS_COMPACT at compile time, which also selects BUTTONS_VERTICAL, each ButtonType
+ * only keeps its port and pin packed in one byte and everything else lives in the bit masks of
+ * each port, for large sets of inputs where the RAM counts, the counters can be reduced defining
+ * BUTTONS_VERTICAL_BITS to the bits needed for the number of samples. The status of all the pins
+ * of a port can be read at once with Buttons_GetStatusMask in any mode.
  */
 #ifndef __BUTTONS_H
 #define __BUTTONS_H
 
+#ifdef BUTTONS_COMPACT
+#ifndef BUTTONS_VERTICAL
+#define BUTTONS_VERTICAL
+#endif
+#ifdef BUTTONS_EVENTS
+#error "BUTTONS_EVENTS keeps times per button, it can not be used along with BUTTONS_COMPACT"
+#endif
+#endif
+
+#ifdef BUTTONS_EVENTS
+#include "queue.h"
+#endif
+
+/**
+  * @defgroup Buttons_vertical Vertical counters sizes, the bits of the counters can be overwritten
+  * from the compiler command line, the number of samples is limited to 2^bits - 1
+  @{ */
+#define BUTTONS_PORTS           6u  /*!< number of GPIO ports that can have buttons */
+#ifndef BUTTONS_VERTICAL_BITS
+#define BUTTONS_VERTICAL_BITS   8u  /*!< bits of the counters, enough for any number of samples */
+#endif
+/**
+  @} */
+
+/**
+ * @brief   Port control structure, each bit is one pin of the port
+ */
+typedef struct _ButtonsPortType
+{
+    uint16_t Mask;      /*!< pins with a button registered*/
+    uint16_t Level;     /*!< pins with active level high*/
+    uint16_t Status;    /*!< debounced status of the pins, one means active*/
+    uint16_t Pressed;   /*!< pins with a press event not read yet*/
+    uint16_t Released;  /*!< pins with a release event not read yet*/
+    uint16_t Count[ BUTTONS_VERTICAL_BITS ]; /*!< vertical counters, word n holds the bit n of each pin*/
+} ButtonsPortType;
+
+#ifdef BUTTONS_COMPACT
+/**
+ * @brief   Button control structure, the status and events are kept in the masks of its port
+ */
+typedef struct _ButtonType
+{
+    uint8_t PortPin;  /*!< Port where the pin is connected on the high nibble and pin on the low one*/
+} ButtonType;
+#else
 /**
  * @brief   Button control structure
  */
@@ -24,7 +92,13 @@ typedef struct _ButtonType
     uint8_t Status;   /*!< Button status, ACTIVE, INACTIVE*/
     uint8_t ActiveLevel; /*!< Active level of the button*/
     uint8_t smState;  /*!< Internal State machine for the button*/
+#ifdef BUTTONS_EVENTS
+    uint8_t Long;     /*!< the long press was already sent for the current press*/
+    uint8_t Click;    /*!< double click detection state*/
+    uint32_t Time;    /*!< release tick of the last click, or next long press or repeat tick*/
+#endif
 } ButtonType;
+#endif
 
 /**
  * @brief   Keyboard control structure  
@@ -35,6 +109,20 @@ typedef struct _KeyboardType
     uint8_t Sample;     /*!< the number of samples necesesary to detect an activation*/
     uint8_t Counter;    /*!< counter for the nmber of bttons registered*/
     ButtonType *BtnBuffer; /*!< pointer to array of ButtonType*/
+#ifdef BUTTONS_VERTICAL
+    uint8_t Bits;       /*!< counter bits needed to count up to Sample*/
+    ButtonsPortType Ports[ BUTTONS_PORTS ]; /*!< debounce state of each port*/
+#endif
+#ifdef BUTTONS_WAKEUP
+    volatile uint8_t Sleeping; /*!< sampling stopped until an edge on one of the buttons*/
+#endif
+#ifdef BUTTONS_EVENTS
+    QueueType *Events;    /*!< queue to write the events, NULL for none*/
+    uint32_t Now;         /*!< tick of the current scan*/
+    uint16_t LongPress;   /*!< milliseconds held to send a long press, zero to disable*/
+    uint16_t DoubleClick; /*!< milliseconds from a click to the next press for a double click*/
+    uint16_t Repeat;      /*!< milliseconds between repeats after a long press, zero to disable*/
+#endif
 } KeyboardType;
 
 
@@ -45,9 +133,24 @@ typedef enum _BtnStatus
 {
     BTN_IDLE = 0,   /*!< No event*/
     BTN_PRESSED,    /*!< button has been pressed*/
-    BTN_RELEASED    /*!< button has been released*/
+    BTN_RELEASED,   /*!< button has been released*/
+    BTN_LONG_PRESS, /*!< button held for the long press time*/
+    BTN_DOUBLE_CLICK, /*!< button pressed again right after a click*/
+    BTN_REPEAT      /*!< button still held after a long press*/
 } BtnEvents;
 
+#ifdef BUTTONS_EVENTS
+/**
+ * @brief   Button event written into the events queue
+ */
+typedef struct _ButtonEventType
+{
+    uint32_t Time;    /*!< tick when the event was detected*/
+    uint8_t Button;   /*!< button number as returned by Buttons_Register*/
+    uint8_t Event;    /*!< the event, one of BtnEvents*/
+} ButtonEventType;
+#endif
+
 /**
   * @defgroup Buttons_states Button states active (pressed) and inactive
   @{ */
@@ -60,6 +163,17 @@ void Buttons_Init( KeyboardType *Buttons, uint8_t NButtons, uint8_t Samples, But
 uint8_t Buttons_Register( KeyboardType *Buttons, uint8_t Pin, uint8_t Port, uint8_t ActiveLevel );
 uint8_t Buttons_GetStatus( KeyboardType *Buttons, uint8_t Button );
 uint8_t Buttons_GetEvent( KeyboardType *Buttons, uint8_t Button );
+uint16_t Buttons_GetStatusMask( KeyboardType *Buttons, uint8_t Port );
 void Buttons_MainFunction( KeyboardType *Buttons );
+uint16_t Buttons_Debounce( ButtonsPortType *Port, uint16_t Input, uint8_t Samples, uint8_t Bits );
+#ifdef BUTTONS_EVENTS
+uint8_t Buttons_SetQueue( KeyboardType *Buttons, QueueType *Queue );
+void Buttons_SetTimes( KeyboardType *Buttons, uint16_t LongPress, uint16_t DoubleClick, uint16_t Repeat );
+#endif
+#ifdef BUTTONS_WAKEUP
+void Buttons_Wakeup( KeyboardType *Buttons );
+uint8_t Buttons_IsSleeping( const KeyboardType *Buttons );
+void Buttons_WakeupHook( KeyboardType *Buttons, uint8_t Enable );
+#endif
 
 #endif
@@ -0,0 +1,316 @@
+/**
+ * @file keypad.c
+ * @brief **Matrix keypad scanning engine**
+ *
+ * This is a keypad handler for key matrices of up to 16 rows by 16 columns, the rows are outputs
+ * on one port and the columns are inputs with pull-up on consecutive pins of another port, a key
+ * pressed connects its column to its row. On each scan one row at a time is driven low with a
+ * single write to the BSRR register and all the columns are read at once from the IDR register,
+ * then each row is debounced as a whole with the vertical counters of the buttons module, so the
+ * scan cost depends on the number of rows and not on the number of keys.
+ *
+ * The code was written for the STM32xx family of microcontrollers, but it can be easily ported
+ * to other microcontrollers.
+ */
+#include "bsp.h"
+#include "keypad.h"
+
+/**
+  * @defgroup Boolean true and flase definitions
+  @{ */
+#ifndef FALSE
+#define FALSE 0u /*!< FALSE definition */
+#endif
+
+#ifndef TRUE
+#define TRUE 1u /*!< TRUE definition */
+#endif
+/**
+  @} */
+
+/**
+ * @brief   Array of GPIO ports from the STM32G0xx family
+ */
+static GPIO_TypeDef *Ports[] = { GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOF };
+
+static void Keypad_Ghost( KeypadType *Keypad, const uint16_t *Active, uint16_t *Frozen );
+
+/**
+ * @brief   Initialize the keypad handler
+ *
+ * This function initializes the keypad handler with the size of the matrix and the number of
+ * samples to detect a change, the rows and columns pins shall be set before the first scan with
+ * Keypad_SetRows and Keypad_SetColumns. The keys are numbered from 1 row by row.
+ *
+ * @param Keypad Pointer to the KeypadType structure
+ * @param Rows Number of rows, up to KEYPAD_ROWS
+ * @param Columns Number of columns, up to KEYPAD_COLUMNS
+ * @param Samples Number of samples to detect a press or a release
+ *
+ * @return void
+ */
+void Keypad_Init( KeypadType *Keypad, uint8_t Rows, uint8_t Columns, uint8_t Samples )
+{
+    Keypad->Rows = ( Rows > KEYPAD_ROWS ) ? KEYPAD_ROWS : Rows;
+    Keypad->Columns = ( Columns > KEYPAD_COLUMNS ) ? KEYPAD_COLUMNS : Columns;
+    /*a change shall last at least one sample*/
+    Keypad->Sample = ( Samples == 0u ) ? 1u : Samples;
+#if BUTTONS_VERTICAL_BITS < 8u
+    /*the counters can not go beyond its bits*/
+    if( Keypad->Sample > ( ( 1u << BUTTONS_VERTICAL_BITS ) - 1u ) )
+    {
+        Keypad->Sample = (uint8_t)( ( 1u << BUTTONS_VERTICAL_BITS ) - 1u );
+    }
+#endif
+    /*only the counter bits needed to reach the number of samples are computed*/
+    Keypad->Bits = 0;
+    while( ( Keypad->Bits < BUTTONS_VERTICAL_BITS ) && ( ( Keypad->Sample >> Keypad->Bits ) != 0u ) )
+    {
+        Keypad->Bits++;
+    }
+    Keypad->RowPort = 0;
+    Keypad->ColPort = 0;
+    Keypad->ColPin = 0;
+    Keypad->Ghost = FALSE;
+    for( uint8_t row = 0; row < KEYPAD_ROWS; row++ )
+    {
+        Keypad->Drive[row] = 0;
+        /*all pins read as released until a scan*/
+        Keypad->Frame[row] = 0xFFFFu;
+        Keypad->Keys[row] = (ButtonsPortType){ 0 };
+    }
+}
+
+/**
+ * @brief   Set the rows pins
+ *
+ * This function sets the port and the pins of the rows and computes the BSRR word that drives
+ * each row low and releases the others, the pins shall be configured by the application as
+ * open-drain outputs, with push-pull outputs two keys pressed on the same column short a row
+ * driven low with one driven high, and the ghost detection expects a released row to float.
+ *
+ * @param Keypad Pointer to the KeypadType structure
+ * @param Port Port where the rows are connected
+ * @param Pins Array with the pin of each row, from the first to the last row
+ *
+ * @return uint8_t TRUE if the rows were set, FALSE if the port or a pin is not valid
+ */
+uint8_t Keypad_SetRows( KeypadType *Keypad, uint8_t Port, const uint8_t *Pins )
+{
+    uint8_t result = FALSE;
+    uint32_t rows = 0;
+
+    if( Port < ( sizeof( Ports ) / sizeof( Ports[0] ) ) )
+    {
+        result = TRUE;
+        for( uint8_t row = 0; row < Keypad->Rows; row++ )
+        {
+            if( Pins[row] >= 16u )
+            {
+                result = FALSE;
+            }
+            rows |= ( 1ul << ( Pins[row] & 15u ) );
+        }
+    }
+
+    if( result == TRUE )
+    {
+        Keypad->RowPort = Port;
+        for( uint8_t row = 0; row < Keypad->Rows; row++ )
+        {
+            /*set the other rows and reset the driven one on the same write*/
+            Keypad->Drive[row] = ( rows & ~( 1ul << Pins[row] ) ) | ( 1ul << ( Pins[row] + 16u ) );
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief   Set the columns pins
+ *
+ * This function sets the port and the first pin of the columns, the columns shall be on
+ * consecutive pins of the same port configured as inputs with pull-up by the application.
+ *
+ * @param Keypad Pointer to the KeypadType structure
+ * @param Port Port where the columns are connected
+ * @param Pin Pin of the first column
+ *
+ * @return uint8_t TRUE if the columns were set, FALSE if the port or the pins are not valid
+ */
+uint8_t Keypad_SetColumns( KeypadType *Keypad, uint8_t Port, uint8_t Pin )
+{
+    uint8_t result = FALSE;
+    uint16_t columns = (uint16_t)( ( 1ul << Keypad->Columns ) - 1u );
+
+    if( ( Port < ( sizeof( Ports ) / sizeof( Ports[0] ) ) ) && ( ( Pin + Keypad->Columns ) <= KEYPAD_COLUMNS ) )
+    {
+        Keypad->ColPort = Port;
+        Keypad->ColPin = Pin;
+        for( uint8_t row = 0; row < Keypad->Rows; row++ )
+        {
+            /*the columns are handed to the debounce as active high*/
+            Keypad->Keys[row].Mask = columns;
+            Keypad->Keys[row].Level = columns;
+        }
+        result = TRUE;
+    }
+
+    return result;
+}
+
+/**
+ * @brief   Get the status of a key
+ *
+ * This function returns the status of a key, ACTIVE or INACTIVE. been active means that
+ * the key is pressed otherwise is inactive.
+ *
+ * @param Keypad Pointer to the KeypadType structure
+ * @param Key Key number, from 1 to rows by columns, up to 256 for a 16 by 16 matrix
+ *
+ * @return uint8_t The status of the key
+ */
+uint8_t Keypad_GetStatus( KeypadType *Keypad, uint16_t Key )
+{
+    uint8_t result = BTN_INACTIVE;
+    uint8_t row;
+    uint8_t column;
+
+    if( ( Key > 0u ) && ( Key <= ( Keypad->Rows * Keypad->Columns ) ) )
+    {
+        row = (uint8_t)( ( Key - 1u ) / Keypad->Columns );
+        column = (uint8_t)( ( Key - 1u ) % Keypad->Columns );
+        result = ( ( Keypad->Keys[row].Status >> column ) & 1u );
+    }
+
+    return result;
+}
+
+/**
+ * @brief   Get the event of a key
+ *
+ * This function returns the event of a key, PRESSED or RELEASED. After this fucntion is called
+ * the event is cleared.
+ *
+ * @param Keypad Pointer to the KeypadType structure
+ * @param Key Key number, from 1 to rows by columns, up to 256 for a 16 by 16 matrix
+ *
+ * @return The event of the key
+ */
+uint8_t Keypad_GetEvent( KeypadType *Keypad, uint16_t Key )
+{
+    uint8_t result = BTN_IDLE;
+    ButtonsPortType *row;
+    uint16_t column;
+
+    if( ( Key > 0u ) && ( Key <= ( Keypad->Rows * Keypad->Columns ) ) )
+    {
+        row = &Keypad->Keys[( Key - 1u ) / Keypad->Columns];
+        column = (uint16_t)( 1u << ( ( Key - 1u ) % Keypad->Columns ) );
+        if( ( row->Pressed & column ) != 0u )
+        {
+            result = BTN_PRESSED;
+        }
+        else if( ( row->Released & column ) != 0u )
+        {
+            result = BTN_RELEASED;
+        }
+        else
+        {
+            /*no event*/
+        }
+        row->Pressed &= (uint16_t)~column;
+        row->Released &= (uint16_t)~column;
+    }
+
+    return result;
+}
+
+/**
+ * @brief   Ask for ghosting
+ *
+ * This function returns TRUE if on the last scan some keys kept its status because the keys
+ * pressed could not be told apart from a ghost key.
+ *
+ * @param Keypad Pointer to the KeypadType structure
+ *
+ * @return uint8_t TRUE if there were keys blocked, FALSE otherwise
+ */
+uint8_t Keypad_GetGhost( KeypadType *Keypad )
+{
+    return Keypad->Ghost;
+}
+
+/**
+ * @brief   Main function for the keypad handler
+ *
+ * This function scans all the rows, one write and one read per row, and debounces the keys of
+ * each row at the same time. With KEYPAD_DMA the rows are scanned by the timer and the DMA and
+ * the function just debounces the last frame.
+ *
+ * @param Keypad Pointer to the KeypadType structure
+ */
+void Keypad_MainFunction( KeypadType *Keypad )
+{
+    uint16_t active[ KEYPAD_ROWS ];
+    uint16_t frozen[ KEYPAD_ROWS ];
+
+#ifndef KEYPAD_DMA
+    for( uint8_t row = 0; row < Keypad->Rows; row++ )
+    {
+        /*drive the row and read all the columns at once*/
+        Ports[Keypad->RowPort]->BSRR = Keypad->Drive[row];
+        KEYPAD_SETTLE( );
+        Keypad->Frame[row] = (uint16_t)Ports[Keypad->ColPort]->IDR;
+    }
+#endif
+
+    for( uint8_t row = 0; row < Keypad->Rows; row++ )
+    {
+        /*a key pressed pulls its column low*/
+        active[row] = (uint16_t)~( Keypad->Frame[row] >> Keypad->ColPin ) & Keypad->Keys[row].Mask;
+        frozen[row] = 0;
+    }
+
+    Keypad_Ghost( Keypad, active, frozen );
+
+    for( uint8_t row = 0; row < Keypad->Rows; row++ )
+    {
+        /*the blocked keys are sampled with its current status*/
+        (void)Buttons_Debounce( &Keypad->Keys[row], ( active[row] & (uint16_t)~frozen[row] ) | ( Keypad->Keys[row].Status & frozen[row] ),
+                                Keypad->Sample, Keypad->Bits );
+    }
+}
+
+/**
+ * @brief   Find the keys that can be ghosts
+ *
+ * Two rows with two or more columns pressed in common make a rectangle where any of the four
+ * keys can be a ghost of the other three, those keys are blocked on both rows.
+ *
+ * @param Keypad Pointer to the KeypadType structure
+ * @param Active Keys read as pressed on each row
+ * @param Frozen Keys to block on each row
+ *
+ * @return void
+ */
+static void Keypad_Ghost( KeypadType *Keypad, const uint16_t *Active, uint16_t *Frozen )
+{
+    uint16_t common;
+
+    Keypad->Ghost = FALSE;
+    for( uint8_t row = 0; row < Keypad->Rows; row++ )
+    {
+        for( uint8_t other = row + 1u; other < Keypad->Rows; other++ )
+        {
+            common = Active[row] & Active[other];
+            /*more than one bit set*/
+            if( ( common & (uint16_t)( common - 1u ) ) != 0u )
+            {
+                Frozen[row] |= common;
+                Frozen[other] |= common;
+                Keypad->Ghost = TRUE;
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * @file keypad.h
+ * @brief **Matrix keypad scanning engine**
+ *
+ * This is a keypad handler for key matrices of up to 16 rows by 16 columns, the rows are open-drain
+ * outputs on one port and the columns are inputs with pull-up on consecutive pins of another port,
+ * a key pressed connects its column to its row. Push-pull rows are not allowed, two keys pressed on
+ * the same column would short the row driven low with a row driven high, and the ghost detection
+ * assumes the rows not driven just float. On each scan one row at a time is driven low with a
+ * single write to the BSRR register and all the columns are read at once from the IDR register,
+ * then each row is debounced as a whole with the vertical counters of the buttons module, so the
+ * scan cost depends on the number of rows and not on the number of keys.
+ *
+ * Matrices without diodes show a fourth key (ghost) when three keys on the corners of a rectangle
+ * are pressed, two rows sharing two or more pressed columns can not be told apart from that, so
+ * those keys keep its previous status until the ambiguity is gone.
+ *
+ * Defining KEYPAD_DMA at compile time the rows are not driven by Keypad_MainFunction, a timer
+ * shall move the words of __KeypadType.Drive__ into the BSRR register of the rows port with a DMA
+ * channel on its update event, and move the IDR register of the columns port into
+ * __KeypadType.Frame__ with another DMA channel on a compare event later in the period to let the
+ * lines settle, both in circular mode with one transfer per row. Keypad_MainFunction only
+ * debounces the last frame captured so the CPU is not involved on each row.
+ *
+ * The code was written for the STM32xx family of microcontrollers, but it can be easily ported
+ * to other microcontrollers.
+ */
+#ifndef __KEYPAD_H
+#define __KEYPAD_H
+
+#include "buttons.h"
+
+/**
+  * @defgroup Keypad_sizes Matrix limits, the number of rows can be overwritten from the compiler
+  * command line to save memory
+  @{ */
+#ifndef KEYPAD_ROWS
+#define KEYPAD_ROWS     8u   /*!< maximum number of rows */
+#endif
+#define KEYPAD_COLUMNS  16u  /*!< maximum number of columns, the pins of one port */
+/**
+  @} */
+
+/**
+  * @defgroup Keypad_settle Delay between driving a row and reading the columns, it can be
+  * overwritten from the compiler command line with a few NOPs for long lines
+  @{ */
+#ifndef KEYPAD_SETTLE
+#define KEYPAD_SETTLE( )
+#endif
+/**
+  @} */
+
+/**
+ * @brief   Keypad control structure
+ */
+typedef struct _KeypadType
+{
+    uint8_t Rows;       /*!< the number of rows of the matrix*/
+    uint8_t Columns;    /*!< the number of columns of the matrix*/
+    uint8_t Sample;     /*!< the number of samples necesary to detect a change*/
+    uint8_t Bits;       /*!< counter bits needed to count up to Sample*/
+    uint8_t RowPort;    /*!< port where the rows are connected*/
+    uint8_t ColPort;    /*!< port where the columns are connected*/
+    uint8_t ColPin;     /*!< pin of the first column, the rest are the next ones*/
+    uint8_t Ghost;      /*!< flag set while some keys are blocked because of ghosting*/
+    uint32_t Drive[ KEYPAD_ROWS ];          /*!< BSRR words that drive each row low and the rest high*/
+    volatile uint16_t Frame[ KEYPAD_ROWS ]; /*!< columns port read while each row was driven*/
+    ButtonsPortType Keys[ KEYPAD_ROWS ];    /*!< debounce state of each row, one bit per column*/
+} KeypadType;
+
+void Keypad_Init( KeypadType *Keypad, uint8_t Rows, uint8_t Columns, uint8_t Samples );
+uint8_t Keypad_SetRows( KeypadType *Keypad, uint8_t Port, const uint8_t *Pins );
+uint8_t Keypad_SetColumns( KeypadType *Keypad, uint8_t Port, uint8_t Pin );
+uint8_t Keypad_GetStatus( KeypadType *Keypad, uint16_t Key );
+uint8_t Keypad_GetEvent( KeypadType *Keypad, uint16_t Key );
+uint8_t Keypad_GetGhost( KeypadType *Keypad );
+void Keypad_MainFunction( KeypadType *Keypad );
+
+#endif
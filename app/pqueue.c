@@ -0,0 +1,281 @@
+/**
+ * @file    pqueue.c
+ * @brief   **Static priority queue algorithm**
+ *
+ * This is a multipourpose priority queue implementation capable of handle any kind of Data of any
+ * size, the Elements are stored in a static Buffer organized as a binary heap where the element at
+ * position i has its children at positions 2i + 1 and 2i + 2, the element with the highest
+ * priority is always at position zero. New elements are placed at the end and moved up, reading
+ * takes the first one, moves the last one to its place and then moves it down. Elements are
+ * exchanged byte by byte so no extra memory is needed.
+ *
+ * Elements with the same priority are not guaranteed to be read in the order they were written,
+ * if that is needed the application can add a sequence number to the element and use it in the
+ * Compare function. The queue is not protected against concurrent access.
+ */
+#include <stdint.h>
+#include "pqueue.h"
+#include <string.h>
+
+/**
+  * @defgroup Boolean true and flase definitions
+  @{ */
+#ifndef FALSE
+#define FALSE 0u /*!< FALSE definition */
+#endif
+
+#ifndef TRUE
+#define TRUE 1u /*!< TRUE definition */
+#endif
+/**
+  @} */
+
+static uint8_t *Element_Get( const PQueueType *Queue, uint32_t Index );
+static void Elements_Swap( const PQueueType *Queue, uint32_t A, uint32_t B );
+static void Heap_Up( const PQueueType *Queue, uint32_t Index );
+static void Heap_Down( const PQueueType *Queue, uint32_t Index );
+
+/**
+ * @brief   **Priority queue intilization**
+ *
+ * Set the internal queue Elements as a queue Empty for the first time
+ *
+ * @param Queue     pointer to a PQueueType structure that contains queue control information.
+ * @param Buffer    pointer to memory array to store the elements
+ * @param Elements  number of elements to store
+ * @param Size      size in bytes of each element
+ * @param Compare   function to compare two elements, it shall return a value less than zero when
+ *                  element A has to be read before element B
+ */
+void PQueue_Init( PQueueType *Queue, void *Buffer, uint32_t Elements, uint8_t Size, int32_t (*Compare)( const void *A, const void *B ) )
+{
+    Queue->Buffer   = Buffer;
+    Queue->Elements = Elements;
+    Queue->Size     = Size;
+    Queue->Compare  = Compare;
+
+    Queue->Count = 0u;
+}
+
+/**
+ * @brief   **Write one element into the queue**
+ *
+ * Write an element Data into the queue if there is room for one more element, the element is
+ * placed at the end of the heap and then moved up until its parent has a higher priority.
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information.
+ * @param Data   pointer to Data to be written
+ *
+ * @retval  #TRUE if Data could be written otherwise #FALSE
+ */
+uint8_t PQueue_WriteData( PQueueType *Queue, void *Data )
+{
+    uint8_t result = FALSE; /*assume queue is full*/
+
+    if( Queue->Count < Queue->Elements )
+    {
+        (void)memcpy( Element_Get( Queue, Queue->Count ), Data, Queue->Size );
+        Heap_Up( Queue, Queue->Count ); /*place the new element according to its priority*/
+        Queue->Count++;
+
+        result = TRUE;
+    }
+
+    return result;
+}
+
+/**
+ * @brief   **Read the highest priority element from the queue**
+ *
+ * Read the element with the highest priority if there is at least one element, the last element
+ * takes its place and it is moved down until its children have a lower priority.
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information.
+ * @param Data   pointer to address to store the Data read
+ *
+ * @retval  #TRUE if Data could be read otherwise #FALSE
+ */
+uint8_t PQueue_ReadData( PQueueType *Queue, void *Data )
+{
+    uint8_t result = FALSE; /*assume queue is empty*/
+
+    if( Queue->Count > 0u )
+    {
+        (void)memcpy( Data, Element_Get( Queue, 0u ), Queue->Size );
+        Queue->Count--;
+        /*move the last element to the top and find its place, unless it was the one read*/
+        if( Queue->Count > 0u )
+        {
+            (void)memcpy( Element_Get( Queue, 0u ), Element_Get( Queue, Queue->Count ), Queue->Size );
+            Heap_Down( Queue, 0u );
+        }
+
+        result = TRUE;
+    }
+
+    return result;
+}
+
+/**
+ * @brief   **Peek the highest priority element**
+ *
+ * Return a pointer to the element with the highest priority without removing it from the queue,
+ * the pointer is only valid until the next write or read operation.
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information.
+ *
+ * @retval  Pointer to the element or NULL if the queue is empty
+ */
+void *PQueue_Peek( PQueueType *Queue )
+{
+    void *element = NULL;
+
+    if( Queue->Count > 0u )
+    {
+        element = Queue->Buffer;
+    }
+
+    return element;
+}
+
+/**
+ * @brief   **Inquier if the queue is Empty**
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information
+ *
+ * @retval  #TRUE if queue is Empty otherwise #FALSE
+ */
+uint8_t PQueue_isQueueEmpty( PQueueType *Queue )
+{
+    return ( Queue->Count == 0u ) ? TRUE : FALSE;
+}
+
+/**
+ * @brief   **Inquier if the queue is Full**
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information
+ *
+ * @retval  #TRUE if queue is Full otherwise #FALSE
+ */
+uint8_t PQueue_isQueueFull( PQueueType *Queue )
+{
+    return ( Queue->Count == Queue->Elements ) ? TRUE : FALSE;
+}
+
+/**
+ * @brief   **Number of elements in the queue**
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information
+ *
+ * @retval  A value from zero to Queue->Elements
+ */
+uint32_t PQueue_GetCount( PQueueType *Queue )
+{
+    return Queue->Count;
+}
+
+/**
+ * @brief   **Flush the queue to Empty state**
+ *
+ * Set the queue to Empty state, this function will not erase the data stored in the queue
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information
+ */
+void PQueue_FlushQueue( PQueueType *Queue )
+{
+    Queue->Count = 0u;
+}
+
+/**
+ * @brief   **Get the address of an element**
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information
+ * @param Index position of the element in the heap
+ *
+ * @retval  Pointer to the first byte of the element
+ */
+static uint8_t *Element_Get( const PQueueType *Queue, uint32_t Index )
+{
+    /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+    return &( (uint8_t *)Queue->Buffer )[ Index * Queue->Size ];
+}
+
+/**
+ * @brief   **Exchange two elements**
+ *
+ * The elements are exchanged byte by byte to avoid the need of a temporal element
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information
+ * @param A     position of the first element
+ * @param B     position of the second element
+ */
+static void Elements_Swap( const PQueueType *Queue, uint32_t A, uint32_t B )
+{
+    uint8_t *a = Element_Get( Queue, A );
+    uint8_t *b = Element_Get( Queue, B );
+    uint8_t temp;
+
+    for( uint8_t i = 0u; i < Queue->Size; i++ )
+    {
+        temp = a[ i ];
+        a[ i ] = b[ i ];
+        b[ i ] = temp;
+    }
+}
+
+/**
+ * @brief   **Move an element up in the heap**
+ *
+ * Exchange the element with its parent while the element has a higher priority
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information
+ * @param Index position of the element to move
+ */
+static void Heap_Up( const PQueueType *Queue, uint32_t Index )
+{
+    uint32_t child = Index;
+    uint32_t parent;
+
+    while( child > 0u )
+    {
+        parent = ( child - 1u ) / 2u;
+        /*stop when the parent already has a higher or the same priority*/
+        if( Queue->Compare( Element_Get( Queue, child ), Element_Get( Queue, parent ) ) >= 0 )
+        {
+            break;
+        }
+        Elements_Swap( Queue, child, parent );
+        child = parent;
+    }
+}
+
+/**
+ * @brief   **Move an element down in the heap**
+ *
+ * Exchange the element with its highest priority child while the child has a higher priority
+ *
+ * @param Queue pointer to a PQueueType structure that contains queue control information
+ * @param Index position of the element to move
+ */
+static void Heap_Down( const PQueueType *Queue, uint32_t Index )
+{
+    uint32_t parent = Index;
+    uint32_t child  = ( parent * 2u ) + 1u;
+
+    while( child < Queue->Count )
+    {
+        /*pick the child with the highest priority*/
+        if( ( ( child + 1u ) < Queue->Count ) && ( Queue->Compare( Element_Get( Queue, child + 1u ), Element_Get( Queue, child ) ) < 0 ) )
+        {
+            child++;
+        }
+        /*stop when the parent already has a higher or the same priority*/
+        if( Queue->Compare( Element_Get( Queue, child ), Element_Get( Queue, parent ) ) >= 0 )
+        {
+            break;
+        }
+        Elements_Swap( Queue, child, parent );
+        parent = child;
+        child  = ( parent * 2u ) + 1u;
+    }
+}
@@ -0,0 +1,36 @@
+/**
+ * @file    pqueue.h
+ * @brief   **Static priority queue algorithm**
+ *
+ * This is a multipourpose priority queue implementation capable of handle any kind of data of any
+ * size, the elements are stored in a static buffer provided by the application and organized as a
+ * binary heap, so writing and reading an element takes O(log n). The order is given by a compare
+ * function supplied by the application, the element read is always the one with the highest
+ * priority. The queue does not allow overwriting data it will just stop adding new elements if
+ * is full.
+ */
+#ifndef PQUEUE_H__
+#define PQUEUE_H__
+
+/**
+ * @brief   Priority queue control structure
+ */
+typedef struct _PQueueType
+{
+    void *Buffer;       /*!< Pointer to memory array to store data */
+    uint32_t Elements;  /*!< Number of elements to store queue size */
+    uint8_t Size;       /*!< Size of the elements to store */
+    uint32_t Count;     /*!< Number of elements currently stored */
+    int32_t (*Compare)( const void *A, const void *B ); /*!< less than zero when A goes before B */
+} PQueueType;
+
+void PQueue_Init( PQueueType *Queue, void *Buffer, uint32_t Elements, uint8_t Size, int32_t (*Compare)( const void *A, const void *B ) );
+uint8_t PQueue_WriteData( PQueueType *Queue, void *Data );
+uint8_t PQueue_ReadData( PQueueType *Queue, void *Data );
+void *PQueue_Peek( PQueueType *Queue );
+uint8_t PQueue_isQueueEmpty( PQueueType *Queue );
+uint8_t PQueue_isQueueFull( PQueueType *Queue );
+uint32_t PQueue_GetCount( PQueueType *Queue );
+void PQueue_FlushQueue( PQueueType *Queue );
+
+#endif
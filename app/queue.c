@@ -4,11 +4,39 @@
  *
  * This is a multipourpose queue implementation capable of handle any kind of Data of any syze, the
  * only limitation will be the target memory. The queue does not allow overwriting Data it will just
- * stop adding new Elements when is Full
+ * stop adding new Elements when is Full, unless the overwrite mode is selected with Queue_SetOverwrite
+ * in which case the oldest element is discarded to make room for the new one
+ *
+ * Head and Tail run over two laps of the buffer (from 0 to 2 * Elements - 1), that way a full queue
+ * (Head one lap ahead of Tail) can be told apart from an empty one (Head equal to Tail) without
+ * the need of extra flags written by both sides. Only the producer writes the Head and only the
+ * consumer writes the Tail, which makes the queue safe for a single producer and a single consumer
+ * running in different contexts (ISR and main loop) with no critical sections.
+ *
+ * In overwrite mode the Tail is still written only by the consumer, the producer counts the
+ * elements written (Written) and publishes the first element not discarded (Oldest) before reusing
+ * its slot, the consumer counts the elements read (Read) and jumps over the discarded elements on
+ * its next read. Once an element is copied out the consumer checks Oldest again, if the element
+ * was discarded in the middle of the copy it can be torn and the read is repeated with the next
+ * oldest one. The counters run free so they are compared with no ambiguity no matter how many
+ * laps the producer is ahead of a consumer that has not read for a while.
+ *
+ * Queues initialized with Queue_InitPow2 use free running indexes instead, the buffer position is
+ * obtained masking the index with Elements - 1, which avoids any division or comparison when the
+ * target has no hardware divider.
+ *
+ * For several producers (QUEUE_MPSC) each one claims a slot moving the Reserved index and keeps
+ * the Pending counter incremented while copying its element, the last producer to finish (the one
+ * that brings Pending back to zero) is the one that publishes the Head up to Reserved. Interrupts
+ * nest, so a producer that interrupts another one always finishes first and leaves the publication
+ * to the interrupted one, no producer ever waits for another.
  */
 #include <stdint.h>
 #include "queue.h"
 #include <string.h>
+#if defined( QUEUE_MPSC ) && !defined( UTEST )
+#include "bsp.h" /*CMSIS intrinsics for exclusive access and interrupt masking*/
+#endif
 
 /**
   * @defgroup Boolean true and flase definitions
@@ -23,6 +51,52 @@
 /**
   @} */
 
+/**
+  * @defgroup Statistics update, the operations are removed when QUEUE_STATISTICS is not defined
+  @{ */
+#ifdef QUEUE_STATISTICS
+#define STATISTICS_LEVEL( Queue )            Level_Update( Queue )              /*!< update the high-water mark */
+#define STATISTICS_DROPPED( Queue, Count )   ( (Queue)->Dropped += ( Count ) ) /*!< count the elements lost */
+#else
+#define STATISTICS_LEVEL( Queue )            ( (void)0 ) /*!< statistics disabled */
+#define STATISTICS_DROPPED( Queue, Count )   ( (void)0 ) /*!< statistics disabled */
+#endif
+/**
+  @} */
+
+/**
+  * @defgroup Consumer notification, the call is removed when QUEUE_NOTIFY is not defined
+  @{ */
+#ifdef QUEUE_NOTIFY
+#define NOTIFY_CONSUMER( Queue )  Consumer_Notify( Queue ) /*!< tell the consumer there are new elements */
+#else
+#define NOTIFY_CONSUMER( Queue )  ( (void)0 ) /*!< notification disabled */
+#endif
+/**
+  @} */
+
+static uint32_t Index_Advance( const QueueType *Queue, uint32_t Index, uint32_t Count );
+static uint32_t Index_Slot( const QueueType *Queue, uint32_t Index );
+static uint32_t Elements_Used( const QueueType *Queue, uint32_t Head, uint32_t Tail );
+static uint32_t Producer_Used( const QueueType *Queue, uint32_t Head );
+static void Oldest_Discard( QueueType *Queue, uint32_t Used, uint32_t Count );
+static uint32_t Consumer_Tail( const QueueType *Queue, uint32_t *Read );
+static uint8_t Consumer_Passed( const QueueType *Queue, uint32_t Read );
+static void Consumer_Release( QueueType *Queue, uint32_t Tail, uint32_t Read, uint32_t Count );
+#ifdef QUEUE_STATISTICS
+static void Level_Update( QueueType *Queue );
+#endif
+#ifdef QUEUE_NOTIFY
+static void Consumer_Notify( const QueueType *Queue );
+#endif
+#ifdef QUEUE_MPSC
+static uint8_t Producer_Enter( QueueType *Queue, uint32_t *Index );
+static void Producer_Leave( QueueType *Queue );
+#if defined( __ARM_FEATURE_LDREX ) && !defined( UTEST )
+static uint32_t Atomic_Add( volatile uint32_t *Value, uint32_t Add );
+#endif
+#endif
+
 /**
  * @brief   **Queue intilization**
  *
@@ -37,11 +111,75 @@ void Queue_Init( QueueType *Queue, void *Buffer, uint32_t Elements, uint8_t Size
     Queue->Buffer   = Buffer;
     Queue->Elements = Elements;
     Queue->Size     = Size;
+    Queue->Mask     = 0u;
+    Queue->Overwrite = FALSE;
 
-    Queue->Empty = TRUE;
-    Queue->Full  = FALSE;
     Queue->Head  = 0u;
     Queue->Tail  = 0u;
+    Queue->Written = 0u;
+    Queue->Oldest  = 0u;
+    Queue->Read    = 0u;
+#ifdef QUEUE_MPSC
+    Queue->Reserved = 0u;
+    Queue->Pending  = 0u;
+#endif
+#ifdef QUEUE_STATISTICS
+    Queue_ResetStatistics( Queue );
+#endif
+#ifdef QUEUE_NOTIFY
+    Queue->Notify = NULL;
+#endif
+}
+
+/**
+ * @brief   **Queue intilization for a power of two number of elements**
+ *
+ * Same as Queue_Init but the queue will use free running Head and Tail pointers and a mask to
+ * locate the elements in the buffer, the number of Elements shall be a power of two otherwise
+ * the queue is not initialized
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ * @param Buffer pointer to memory array to store the elements
+ * @param Elements number of elements to store, it shall be a power of two
+ * @param Size size in bytes of each element
+ *
+ * @retval  #TRUE if the queue was initialized otherwise #FALSE
+ */
+uint8_t Queue_InitPow2( QueueType *Queue, void *Buffer, uint32_t Elements, uint8_t Size )
+{
+    uint8_t result = FALSE;
+
+    /*only one bit set means a power of two, also limited to half of the index range*/
+    if( ( Elements != 0u ) && ( ( Elements & ( Elements - 1u ) ) == 0u ) && ( Elements <= 0x80000000u ) )
+    {
+        Queue_Init( Queue, Buffer, Elements, Size );
+        Queue->Mask = Elements - 1u;
+        result      = TRUE;
+    }
+
+    return result;
+}
+
+/**
+ * @brief   **Select the overwrite mode**
+ *
+ * With the overwrite mode enabled the write operations (Queue_WriteData, Queue_WriteBlock and
+ * Queue_Reserve) never fail, when the queue is full the oldest element is discarded to make room
+ * for the new one, keeping always the newest Queue->Elements. The mode shall be selected right
+ * after Queue_Init or Queue_InitPow2 and before the queue is used.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ * @param Overwrite #TRUE to discard the oldest element when full, #FALSE to reject new elements
+ *
+ * @note    Queue_ReadData and Queue_ReadBlock detect an element discarded while it is copied and
+ *          read again, but the elements accessed in place with Queue_Peek or Queue_GetReadRegion
+ *          can be overwritten by the producer before they are released, the consumer shall keep
+ *          the producer out (critical section) from the Peek or GetReadRegion until the Release or
+ *          AdvanceRead, or use the copy functions instead.
+ */
+void Queue_SetOverwrite( QueueType *Queue, uint8_t Overwrite )
+{
+    Queue->Overwrite = Overwrite;
 }
 
 /**
@@ -51,6 +189,10 @@ void Queue_Init( QueueType *Queue, void *Buffer, uint32_t Elements, uint8_t Size
  * make sure if is not full before writing the Data, in case of full queue the Data will not be written
  * and the function will return FALSE, otherwise the Data will be written and the function will return TRUE
  *
+ * The Data is copied before the new Head is published, so the consumer never sees an element that
+ * has not been completely written. This is the producer side and it shall be called from a single
+ * context. In overwrite mode the oldest element is discarded when the queue is full.
+ *
  * @param Queue pointer to a QUEUE_HandleTypeDef structure that contains queue control information.
  * @param Data   pointer to Data to be written
  *
@@ -58,30 +200,72 @@ void Queue_Init( QueueType *Queue, void *Buffer, uint32_t Elements, uint8_t Size
  */
 uint8_t Queue_WriteData( QueueType *Queue, void *Data )
 {
-    uint8_t result = FALSE; /*assume queue is full*/
+    uint8_t result = FALSE;     /*assume queue is full*/
+    uint32_t head = Queue->Head; /*only the producer modifies the Head*/
+    uint32_t used = Producer_Used( Queue, head );
+
+    /*in overwrite mode make room discarding the oldest element*/
+    if( ( Queue->Overwrite == TRUE ) && ( used == Queue->Elements ) )
+    {
+        Oldest_Discard( Queue, used, 1u );
+        used--;
+    }
 
     /* fist check if queue is not full*/
-    if( Queue->Full == FALSE )
+    if( used < Queue->Elements )
     {
         /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
-        (void)memcpy( &( (uint8_t *)Queue->Buffer )[ Queue->Head * Queue->Size ], Data, Queue->Size );
-        Queue->Empty = FALSE;           /*signal queue is not empty*/
-        Queue->Head++;                  /*move head pointer to the next element*/
-        Queue->Head %= Queue->Elements; /*if head pointer is at the end of the queue, move it to the beginning*/
-
-        /*check if queue is full, this only could happens when Head pointer reach Tail after
-        writting an element*/
-        if( Queue->Head == Queue->Tail )
-        {
-            Queue->Full = TRUE;
-        }
+        (void)memcpy( &( (uint8_t *)Queue->Buffer )[ Index_Slot( Queue, head ) * Queue->Size ], Data, Queue->Size );
+        QUEUE_BARRIER( );                           /*element shall be in memory before moving the head*/
+        Queue->Head = Index_Advance( Queue, head, 1u ); /*move head pointer to the next element*/
+        Queue->Written++;
+        STATISTICS_LEVEL( Queue );
+        NOTIFY_CONSUMER( Queue );
 
         result = TRUE;
     }
+    else
+    {
+        STATISTICS_DROPPED( Queue, 1u );
+    }
 
     return result;  /*return the result of the operation*/
 }
 
+#ifdef QUEUE_MPSC
+/**
+ * @brief   **Write one element into the queue from several producers**
+ *
+ * Same as Queue_WriteData but the function can be called at the same time from several interrupts
+ * (of any priority) and from the main loop, the slot is claimed atomically and the element becomes
+ * visible to the consumer once all the producers that were writing at the same time have finished.
+ * When a queue is written with this function all its producers shall use it, the overwrite mode
+ * is not supported. The high-water mark could miss a peak if a producer interrupts another one
+ * while it is been updated.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ * @param Data   pointer to Data to be written
+ *
+ * @retval  #TRUE if Data could be written otherwise #FALSE
+ */
+uint8_t Queue_WriteDataMpsc( QueueType *Queue, void *Data )
+{
+    uint32_t index;
+    uint8_t result = Producer_Enter( Queue, &index ); /*claim a free slot*/
+
+    if( result == TRUE )
+    {
+        /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+        (void)memcpy( &( (uint8_t *)Queue->Buffer )[ Index_Slot( Queue, index ) * Queue->Size ], Data, Queue->Size );
+        Producer_Leave( Queue ); /*publish the element if no other producer is in the middle*/
+        STATISTICS_LEVEL( Queue );
+        NOTIFY_CONSUMER( Queue );
+    }
+
+    return result;
+}
+#endif
+
 /**
  * @brief   **Read one element from the queue**
  *
@@ -89,6 +273,10 @@ uint8_t Queue_WriteData( QueueType *Queue, void *Data )
  * if is not empty before reading the Data, in case of empty queue the Data will not be read and the
  * function will return FALSE, otherwise the Data will be read and the function will return TRUE
  *
+ * The slot is given back to the producer only after the Data has been copied out. This is the
+ * consumer side and it shall be called from a single context. In overwrite mode an element
+ * discarded by the producer while it was copied is dropped and the next oldest one is read.
+ *
  * @param Queue pointer to a QueueType structure that contains queue control information.
  * @param Data   pointer to address to store the Data read
  *
@@ -97,34 +285,427 @@ uint8_t Queue_WriteData( QueueType *Queue, void *Data )
 uint8_t Queue_ReadData( QueueType *Queue, void *Data )
 {
     uint8_t result = FALSE; /*assume queue is empty*/
+    uint8_t retry;
+    uint32_t read;
+    uint32_t tail;
+    uint32_t used;
 
-    /* first check if queue is not empty*/
-    if( Queue->Empty == FALSE )
+    do
     {
+        retry = FALSE;
+        tail  = Consumer_Tail( Queue, &read ); /*only the consumer modifies the Tail*/
+        used  = Elements_Used( Queue, Queue->Head, tail );
+
+        /*the producer went a lap over the tail while it was read*/
+        if( used > Queue->Elements )
+        {
+            retry = TRUE;
+        }
+        /* first check if queue is not empty*/
+        else if( used > 0u )
+        {
+            QUEUE_BARRIER( ); /*do not read the element before the head has been read*/
+            /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+            (void)memcpy( Data, &( (uint8_t *)Queue->Buffer )[ Index_Slot( Queue, tail ) * Queue->Size ], Queue->Size ); /* cppcheck-suppress misra-c2012-18.4*/
+            QUEUE_BARRIER( ); /*element shall be copied before releasing the slot*/
+            /*the element could be torn if it was discarded in the middle of the copy*/
+            if( Consumer_Passed( Queue, read ) == TRUE )
+            {
+                retry = TRUE;
+            }
+            else
+            {
+                Consumer_Release( Queue, tail, read, 1u ); /*move tail pointer to the next element*/
+                result = TRUE;
+            }
+        }
+        else
+        {
+            /*queue empty*/
+        }
+    } while( retry == TRUE );
+
+    return result; /*return the result of the operation*/
+}
+
+/**
+ * @brief   **Write a block of elements into the queue**
+ *
+ * Write up to Count consecutive elements from Data into the queue, only the elements that fit in
+ * the free space are written. The copy is done with at most two memcpy calls, one up to the end of
+ * the buffer and another one from the beginning of the buffer when the block wraps around. The
+ * new Head is published once for the whole block.
+ *
+ * In overwrite mode the oldest elements are discarded to make room for the whole block, if the
+ * block is larger than the queue only its last Queue->Elements are written.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ * @param Data  pointer to the array of elements to be written
+ * @param Count number of elements to write
+ *
+ * @retval  The number of elements written, zero if the queue is full
+ */
+uint32_t Queue_WriteBlock( QueueType *Queue, void *Data, uint32_t Count )
+{
+    uint32_t head     = Queue->Head; /*only the producer modifies the Head*/
+    uint32_t used     = Producer_Used( Queue, head );
+    uint32_t elements = Queue->Elements - used;
+    uint32_t slot     = Index_Slot( Queue, head );
+    uint32_t count    = Count;
+    uint8_t *source   = (uint8_t *)Data;
+    uint32_t first;
+
+    /*in overwrite mode make room for the block discarding the oldest elements*/
+    if( ( Queue->Overwrite == TRUE ) && ( count > elements ) )
+    {
+        /*only the newest elements of a block larger than the queue are kept*/
+        if( count > Queue->Elements )
+        {
+            STATISTICS_DROPPED( Queue, count - Queue->Elements );
+            source = &source[ ( count - Queue->Elements ) * Queue->Size ];
+            count  = Queue->Elements;
+        }
+        Oldest_Discard( Queue, used, count - elements );
+        elements = count;
+    }
+
+    /*write only the elements that fit*/
+    if( count < elements )
+    {
+        elements = count;
+    }
+
+    if( elements > 0u )
+    {
+        /*elements that fit before reaching the end of the buffer*/
+        first = Queue->Elements - slot;
+        if( first > elements )
+        {
+            first = elements;
+        }
+
         /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
-        (void)memcpy( Data, &( (uint8_t *)Queue->Buffer )[ Queue->Tail * Queue->Size ], Queue->Size ); /* cppcheck-suppress misra-c2012-18.4*/
-        Queue->Full = FALSE;            /*signal queue is not full*/
-        Queue->Tail++;                  /*move tail pointer to the next element*/
-        Queue->Tail %= Queue->Elements; /*if tail pointer is at the end of the queue, move it to the beginning*/
-
-        /*check if queue is empty, this only could happens when Tail pointer reach Head after
-        reading an element*/
-        if( Queue->Tail == Queue->Head )
+        (void)memcpy( &( (uint8_t *)Queue->Buffer )[ slot * Queue->Size ], source, first * Queue->Size );
+        (void)memcpy( Queue->Buffer, &source[ first * Queue->Size ], ( elements - first ) * Queue->Size );
+        QUEUE_BARRIER( );                                   /*elements shall be in memory before moving the head*/
+        Queue->Head = Index_Advance( Queue, head, elements ); /*move head pointer after the last element*/
+        Queue->Written += elements;
+        STATISTICS_LEVEL( Queue );
+        NOTIFY_CONSUMER( Queue );
+    }
+
+    STATISTICS_DROPPED( Queue, count - elements );
+
+    return elements;
+}
+
+/**
+ * @brief   **Read a block of elements from the queue**
+ *
+ * Read up to Count consecutive elements from the queue into Data, only the elements available are
+ * read. The copy is done with at most two memcpy calls, one up to the end of the buffer and another
+ * one from the beginning of the buffer when the block wraps around. The new Tail is published once
+ * for the whole block. In overwrite mode the block is read again from the oldest element if the
+ * producer discarded any of its elements while they were copied.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ * @param Data  pointer to the array to store the elements read
+ * @param Count maximum number of elements to read
+ *
+ * @retval  The number of elements read, zero if the queue is empty
+ */
+uint32_t Queue_ReadBlock( QueueType *Queue, void *Data, uint32_t Count )
+{
+    uint8_t retry;
+    uint32_t read;
+    uint32_t tail;
+    uint32_t elements;
+    uint32_t slot;
+    uint32_t first;
+
+    do
+    {
+        retry    = FALSE;
+        tail     = Consumer_Tail( Queue, &read ); /*only the consumer modifies the Tail*/
+        elements = Elements_Used( Queue, Queue->Head, tail );
+        slot     = Index_Slot( Queue, tail );
+
+        /*the producer went a lap over the tail while it was read*/
+        if( elements > Queue->Elements )
         {
-            Queue->Empty = TRUE;
+            retry = TRUE;
         }
+        else
+        {
+            /*read only the elements available*/
+            if( Count < elements )
+            {
+                elements = Count;
+            }
+
+            if( elements > 0u )
+            {
+                /*elements available before reaching the end of the buffer*/
+                first = Queue->Elements - slot;
+                if( first > elements )
+                {
+                    first = elements;
+                }
 
+                QUEUE_BARRIER( ); /*do not read the elements before the head has been read*/
+                /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+                (void)memcpy( Data, &( (uint8_t *)Queue->Buffer )[ slot * Queue->Size ], first * Queue->Size );
+                /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+                (void)memcpy( &( (uint8_t *)Data )[ first * Queue->Size ], Queue->Buffer, ( elements - first ) * Queue->Size );
+                QUEUE_BARRIER( ); /*elements shall be copied before releasing the slots*/
+                /*some elements could be torn if they were discarded in the middle of the copy*/
+                if( Consumer_Passed( Queue, read ) == TRUE )
+                {
+                    retry = TRUE;
+                }
+                else
+                {
+                    Consumer_Release( Queue, tail, read, elements ); /*move tail pointer after the last element*/
+                }
+            }
+        }
+    } while( retry == TRUE );
+
+    return elements;
+}
+
+/**
+ * @brief   **Reserve the next free element**
+ *
+ * Return a pointer to the element where the next write will take place, so the application can
+ * build the element directly in the queue buffer instead of copying it. The element is not
+ * visible to the consumer until Queue_Commit is called. Calling the function again before the
+ * commit returns the same element. In overwrite mode the oldest element is discarded when the
+ * queue is full.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ *
+ * @retval  Pointer to the free element or NULL if the queue is full
+ */
+void *Queue_Reserve( QueueType *Queue )
+{
+    void *element = NULL;        /*assume queue is full*/
+    uint32_t head = Queue->Head; /*only the producer modifies the Head*/
+    uint32_t used = Producer_Used( Queue, head );
+
+    /*in overwrite mode make room discarding the oldest element*/
+    if( ( Queue->Overwrite == TRUE ) && ( used == Queue->Elements ) )
+    {
+        Oldest_Discard( Queue, used, 1u );
+        used--;
+    }
+
+    if( used < Queue->Elements )
+    {
+        /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+        element = &( (uint8_t *)Queue->Buffer )[ Index_Slot( Queue, head ) * Queue->Size ];
+    }
+    else
+    {
+        STATISTICS_DROPPED( Queue, 1u );
+    }
+
+    return element;
+}
+
+/**
+ * @brief   **Commit the element previously reserved**
+ *
+ * Make visible to the consumer the element obtained with Queue_Reserve, the function shall be
+ * called only after the element has been completely written.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ *
+ * @retval  #TRUE if the element was commited otherwise #FALSE in case of full queue
+ */
+uint8_t Queue_Commit( QueueType *Queue )
+{
+    return Queue_AdvanceWrite( Queue, 1u );
+}
+
+/**
+ * @brief   **Peek the oldest element**
+ *
+ * Return a pointer to the oldest element in the queue so it can be processed in place without
+ * copying it. The element stays in the queue until Queue_Release is called, in overwrite mode the
+ * producer shall not run until then because it could write over the element.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ *
+ * @retval  Pointer to the oldest element or NULL if the queue is empty
+ */
+void *Queue_Peek( QueueType *Queue )
+{
+    void *element = NULL; /*assume queue is empty*/
+    uint32_t read;
+    uint32_t tail = Consumer_Tail( Queue, &read ); /*only the consumer modifies the Tail*/
+    uint32_t used = Elements_Used( Queue, Queue->Head, tail );
+
+    if( ( used > 0u ) && ( used <= Queue->Elements ) )
+    {
+        QUEUE_BARRIER( ); /*do not read the element before the head has been read*/
+        /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+        element = &( (uint8_t *)Queue->Buffer )[ Index_Slot( Queue, tail ) * Queue->Size ];
+    }
+
+    return element;
+}
+
+/**
+ * @brief   **Release the oldest element**
+ *
+ * Remove from the queue the element obtained with Queue_Peek giving back its memory to the
+ * producer, the pointer returned by Queue_Peek shall not be used after this call.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ *
+ * @retval  #TRUE if the element was released otherwise #FALSE in case of empty queue
+ */
+uint8_t Queue_Release( QueueType *Queue )
+{
+    return Queue_AdvanceRead( Queue, 1u );
+}
+
+/**
+ * @brief   **Get the contiguous free region**
+ *
+ * Return the largest number of free elements that are contiguous in memory starting at the Head,
+ * the region can be handed to a DMA channel (or any other peripheral) to write the elements
+ * directly into the queue buffer. Once the transfer is done call Queue_AdvanceWrite with the
+ * number of elements written. The region stops at the end of the buffer, a second call after the
+ * advance returns the remaining space at the beginning of the buffer.
+ *
+ * @param Queue  pointer to a QueueType structure that contains queue control information.
+ * @param Region pointer to store the address of the first free element
+ *
+ * @retval  The number of contiguous free elements, zero if the queue is full
+ */
+uint32_t Queue_GetWriteRegion( QueueType *Queue, void **Region )
+{
+    uint32_t head     = Queue->Head; /*only the producer modifies the Head*/
+    uint32_t slot     = Index_Slot( Queue, head );
+    uint32_t elements = Queue->Elements - Producer_Used( Queue, head );
+
+    /*the region can not go beyond the end of the buffer*/
+    if( elements > ( Queue->Elements - slot ) )
+    {
+        elements = Queue->Elements - slot;
+    }
+
+    /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+    *Region = &( (uint8_t *)Queue->Buffer )[ slot * Queue->Size ];
+
+    return elements;
+}
+
+/**
+ * @brief   **Move the Head after an external write**
+ *
+ * Make visible to the consumer a number of elements written directly in the buffer using
+ * Queue_Reserve or Queue_GetWriteRegion.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ * @param Count number of elements written
+ *
+ * @retval  #TRUE if the Head was moved otherwise #FALSE when there is no room for Count elements
+ */
+uint8_t Queue_AdvanceWrite( QueueType *Queue, uint32_t Count )
+{
+    uint8_t result = FALSE;     /*assume there is no room*/
+    uint32_t head = Queue->Head; /*only the producer modifies the Head*/
+
+    if( Count <= ( Queue->Elements - Producer_Used( Queue, head ) ) )
+    {
+        QUEUE_BARRIER( );                              /*elements shall be in memory before moving the head*/
+        Queue->Head = Index_Advance( Queue, head, Count ); /*move head pointer after the last element*/
+        Queue->Written += Count;
+        STATISTICS_LEVEL( Queue );
+        NOTIFY_CONSUMER( Queue );
+        result      = TRUE;
+    }
+
+    return result;
+}
+
+/**
+ * @brief   **Get the contiguous stored region**
+ *
+ * Return the largest number of stored elements that are contiguous in memory starting at the Tail,
+ * the region can be handed to a DMA channel (or any other peripheral) to transmit the elements
+ * directly from the queue buffer. Once the transfer is done call Queue_AdvanceRead with the number
+ * of elements transmitted. The region stops at the end of buffer, a second call after the advance
+ * returns the elements stored at the beginning of the buffer. In overwrite mode the producer shall
+ * not run until the advance because it could write over the elements of the region.
+ *
+ * @param Queue  pointer to a QueueType structure that contains queue control information.
+ * @param Region pointer to store the address of the oldest element
+ *
+ * @retval  The number of contiguous stored elements, zero if the queue is empty
+ */
+uint32_t Queue_GetReadRegion( QueueType *Queue, void **Region )
+{
+    uint32_t read;
+    uint32_t tail     = Consumer_Tail( Queue, &read ); /*only the consumer modifies the Tail*/
+    uint32_t slot     = Index_Slot( Queue, tail );
+    uint32_t elements = Elements_Used( Queue, Queue->Head, tail );
+
+    /*the producer went a lap over the tail while it was read*/
+    if( elements > Queue->Elements )
+    {
+        elements = 0u;
+    }
+
+    /*the region can not go beyond the end of the buffer*/
+    if( elements > ( Queue->Elements - slot ) )
+    {
+        elements = Queue->Elements - slot;
+    }
+
+    QUEUE_BARRIER( ); /*do not read the elements before the head has been read*/
+    /* cppcheck-suppress misra-c2012-11.5 ; convertion is neccesary to supress compiler warning */
+    *Region = &( (uint8_t *)Queue->Buffer )[ slot * Queue->Size ];
+
+    return elements;
+}
+
+/**
+ * @brief   **Move the Tail after an external read**
+ *
+ * Give back to the producer a number of elements consumed directly from the buffer using
+ * Queue_Peek or Queue_GetReadRegion.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information.
+ * @param Count number of elements consumed
+ *
+ * @retval  #TRUE if the Tail was moved otherwise #FALSE when there are less than Count elements
+ */
+uint8_t Queue_AdvanceRead( QueueType *Queue, uint32_t Count )
+{
+    uint8_t result = FALSE; /*assume there are not enough elements*/
+    uint32_t read;
+    uint32_t tail = Consumer_Tail( Queue, &read ); /*only the consumer modifies the Tail*/
+    uint32_t used = Elements_Used( Queue, Queue->Head, tail );
+
+    if( ( Count <= used ) && ( used <= Queue->Elements ) )
+    {
+        QUEUE_BARRIER( );                          /*elements shall be consumed before releasing the slots*/
+        Consumer_Release( Queue, tail, read, Count ); /*move tail pointer after the last element*/
         result = TRUE;
     }
 
-    return result; /*return the result of the operation*/
+    return result;
 }
 
 /**
  * @brief   **Inquier if the queue is Empty**
  *
- * Return the internal queue Empty flag, the flag is set when the read and write operations
- * has been carried out and the queue is empty
+ * Return if the queue is empty, the queue is empty when the Tail pointer has reached the Head
+ * pointer
  *
  * @param Queue pointer to a QueueType structure that contains queue control information
  *
@@ -132,18 +713,537 @@ uint8_t Queue_ReadData( QueueType *Queue, void *Data )
  */
 uint8_t Queue_isQueueEmpty( QueueType *Queue )
 {
-    return Queue->Empty;
+    uint32_t read;
+
+    return ( Queue->Head == Consumer_Tail( Queue, &read ) ) ? TRUE : FALSE;
+}
+
+/**
+ * @brief   **Inquier if the queue is Full**
+ *
+ * Return if the queue is full, the queue is full when the Head pointer is one complete lap ahead
+ * of the Tail pointer
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ *
+ * @retval  #TRUE if queue is Full otherwise #FALSE
+ */
+uint8_t Queue_isQueueFull( QueueType *Queue )
+{
+    return ( Queue_GetCount( Queue ) == Queue->Elements ) ? TRUE : FALSE;
+}
+
+/**
+ * @brief   **Number of elements in the queue**
+ *
+ * Return the number of elements currently stored in the queue
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ *
+ * @retval  A value from zero to Queue->Elements
+ */
+uint32_t Queue_GetCount( QueueType *Queue )
+{
+    uint32_t read;
+    uint32_t used = Elements_Used( Queue, Queue->Head, Consumer_Tail( Queue, &read ) );
+
+    /*the producer could have gone a lap over the tail while it was read*/
+    return ( used > Queue->Elements ) ? Queue->Elements : used;
 }
 
 /**
  * @brief   **Flush the queue to Empty state**
  *
- * Set the internal queue Empty flag, Head and Tail set zero and indication of queue not Full and Empty
- * this function will not erase the data stored in the queue, just set the queue to Empty state
+ * Move the Tail pointer to the Head pointer position discarding all the elements stored, this
+ * function will not erase the data stored in the queue, just set the queue to Empty state. Since
+ * only the Tail is modified the function shall be called from the consumer side
  *
  * @param Queue pointer to a QueueType structure that contains queue control information
  */
 void Queue_FlushQueue( QueueType *Queue )
 {
-    Queue_Init( Queue, Queue->Buffer, Queue->Elements, Queue->Size );
+    uint32_t read;
+    uint32_t tail;
+    uint32_t used;
+
+    do
+    {
+        tail = Consumer_Tail( Queue, &read );
+        used = Elements_Used( Queue, Queue->Head, tail );
+    } while( used > Queue->Elements ); /*the producer went a lap over the tail while it was read*/
+
+    Consumer_Release( Queue, tail, read, used );
+}
+
+#ifdef QUEUE_NOTIFY
+/**
+ * @brief   **Set the consumer notification**
+ *
+ * The function is called from the producer context right after new elements are made visible to
+ * the consumer, so it shall be short and safe to call from an interrupt, with Queue_WriteDataMpsc
+ * it is called once per element written from each of the producers.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Notify function to call, NULL to disable the notification
+ */
+void Queue_SetNotify( QueueType *Queue, void (*Notify)(void) )
+{
+    Queue->Notify = Notify;
+}
+#endif
+
+#ifdef QUEUE_STATISTICS
+/**
+ * @brief   **Get the queue high-water mark**
+ *
+ * Return the maximum number of elements stored at the same time since the queue was initialized
+ * or since the last call to Queue_ResetStatistics
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ *
+ * @retval  A value from zero to Queue->Elements
+ */
+uint32_t Queue_GetHighWater( QueueType *Queue )
+{
+    return Queue->HighWater;
+}
+
+/**
+ * @brief   **Get the number of elements lost**
+ *
+ * Return the number of elements that could not be written because the queue was full, in
+ * overwrite mode it is the number of old elements discarded to make room for the new ones
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ *
+ * @retval  Number of elements lost since the last reset
+ */
+uint32_t Queue_GetDropped( QueueType *Queue )
+{
+    return Queue->Dropped;
+}
+
+/**
+ * @brief   **Reset the queue statistics**
+ *
+ * Set the high-water mark to the current number of elements and the dropped counter to zero,
+ * the counters are updated by the producer so the function should not be called from a context
+ * that could interrupt it (or be interrupted by it)
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ */
+void Queue_ResetStatistics( QueueType *Queue )
+{
+    Queue->HighWater = Producer_Used( Queue, Queue->Head );
+    Queue->Dropped   = 0u;
+}
+#endif
+
+/**
+ * @brief   **Advance a queue index**
+ *
+ * Move the index the given number of elements, once the index reach the second lap of the
+ * buffer it is wrapped back to zero, the operation is done with a substraction to avoid a division.
+ * Power of two queues just let the index free run and wrap on its own
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Index Head or Tail value to advance
+ * @param Count number of elements to advance, it shall no be larger than Queue->Elements
+ *
+ * @retval  The new index value
+ */
+static uint32_t Index_Advance( const QueueType *Queue, uint32_t Index, uint32_t Count )
+{
+    uint32_t next = Index + Count;
+
+    if( ( Queue->Mask == 0u ) && ( next >= ( Queue->Elements * 2u ) ) )
+    {
+        next -= ( Queue->Elements * 2u );
+    }
+
+    return next;
+}
+
+/**
+ * @brief   **Get the buffer slot of a queue index**
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Index Head or Tail value
+ *
+ * @retval  The element position inside the buffer, from 0 to Queue->Elements - 1
+ */
+static uint32_t Index_Slot( const QueueType *Queue, uint32_t Index )
+{
+    uint32_t slot;
+
+    if( Queue->Mask != 0u )
+    {
+        slot = Index & Queue->Mask;
+    }
+    else
+    {
+        slot = ( Index < Queue->Elements ) ? Index : ( Index - Queue->Elements );
+    }
+
+    return slot;
+}
+
+/**
+ * @brief   **Number of elements stored**
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Head  Head value to use in the calculation
+ * @param Tail  Tail value to use in the calculation
+ *
+ * @retval  The number of elements between the Tail and the Head
+ */
+static uint32_t Elements_Used( const QueueType *Queue, uint32_t Head, uint32_t Tail )
+{
+    uint32_t used;
+
+    if( ( Queue->Mask != 0u ) || ( Head >= Tail ) )
+    {
+        used = Head - Tail; /*unsigned substraction also handles the free running wrap*/
+    }
+    else
+    {
+        used = ( Head + ( Queue->Elements * 2u ) ) - Tail;
+    }
+
+    return used;
+}
+
+/**
+ * @brief   **Number of elements stored seen by the producer**
+ *
+ * In overwrite mode the Tail could be behind elements already discarded, so the elements are
+ * counted from the newest of the elements read by the consumer and the oldest element kept.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Head  Head value to use in the calculation
+ *
+ * @retval  The number of elements the producer shall not write over
+ */
+static uint32_t Producer_Used( const QueueType *Queue, uint32_t Head )
+{
+    uint32_t used;
+    uint32_t read;
+
+    if( Queue->Overwrite == TRUE )
+    {
+        read = Queue->Read;
+        if( (int32_t)( Queue->Oldest - read ) > 0 )
+        {
+            read = Queue->Oldest;
+        }
+        used = Queue->Written - read;
+    }
+    else
+    {
+        used = Elements_Used( Queue, Head, Queue->Tail );
+    }
+
+    return used;
+}
+
+/**
+ * @brief   **Discard the oldest elements**
+ *
+ * Used in overwrite mode to make room for new elements, the producer moves the oldest element
+ * kept and the consumer applies it on its next read. The new value is in memory before the slots
+ * are written again so the consumer can tell an element it was copying has been written over.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Used  number of elements stored returned by Producer_Used
+ * @param Count number of elements to discard, it shall no be larger than the elements stored
+ */
+static void Oldest_Discard( QueueType *Queue, uint32_t Used, uint32_t Count )
+{
+    Queue->Oldest = ( Queue->Written - Used ) + Count;
+    QUEUE_BARRIER( ); /*the discard shall be visible before the slots are written again*/
+    STATISTICS_DROPPED( Queue, Count );
+}
+
+/**
+ * @brief   **Get the Tail of the oldest element kept**
+ *
+ * In overwrite mode the Tail is moved over the elements discarded by the producer since the last
+ * read, the index only runs over two laps (or free with a mask) so the distance is reduced to it.
+ * Oldest is read before the Head so the Head is always the one of the last element written when
+ * Oldest was set or a later one.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Read  pointer to store the number of elements read matching the Tail returned
+ *
+ * @retval  The Tail value to use
+ */
+static uint32_t Consumer_Tail( const QueueType *Queue, uint32_t *Read )
+{
+    uint32_t tail = Queue->Tail;
+    uint32_t oldest;
+    uint32_t skip;
+
+    *Read = Queue->Read;
+    if( Queue->Overwrite == TRUE )
+    {
+        oldest = Queue->Oldest;
+        skip   = oldest - *Read;
+        if( (int32_t)skip > 0 )
+        {
+            if( Queue->Mask == 0u )
+            {
+                skip %= ( Queue->Elements * 2u );
+            }
+            tail  = Index_Advance( Queue, tail, skip );
+            *Read = oldest;
+        }
+        QUEUE_BARRIER( ); /*do not read the head before the oldest element*/
+    }
+
+    return tail;
+}
+
+/**
+ * @brief   **Ask if the elements read were discarded**
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Read  number of elements read returned by Consumer_Tail
+ *
+ * @retval  #TRUE if in overwrite mode the producer discarded the element at Read or a newer one
+ */
+static uint8_t Consumer_Passed( const QueueType *Queue, uint32_t Read )
+{
+    return ( ( Queue->Overwrite == TRUE ) && ( (int32_t)( Queue->Oldest - Read ) > 0 ) ) ? TRUE : FALSE;
+}
+
+/**
+ * @brief   **Give back the slots to the producer**
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Tail  Tail value returned by Consumer_Tail
+ * @param Read  number of elements read returned by Consumer_Tail
+ * @param Count number of elements consumed
+ */
+static void Consumer_Release( QueueType *Queue, uint32_t Tail, uint32_t Read, uint32_t Count )
+{
+    Queue->Tail = Index_Advance( Queue, Tail, Count );
+    Queue->Read = Read + Count;
+}
+
+#ifdef QUEUE_STATISTICS
+/**
+ * @brief   **Update the high-water mark**
+ *
+ * Called by the producer after moving the Head, keep the largest number of elements stored
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ */
+static void Level_Update( QueueType *Queue )
+{
+    uint32_t used = Producer_Used( Queue, Queue->Head );
+
+    if( used > Queue->HighWater )
+    {
+        Queue->HighWater = used;
+    }
 }
+#endif
+
+#ifdef QUEUE_NOTIFY
+/**
+ * @brief   **Call the consumer notification**
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ */
+static void Consumer_Notify( const QueueType *Queue )
+{
+    if( Queue->Notify != NULL )
+    {
+        Queue->Notify( );
+    }
+}
+#endif
+
+#ifdef QUEUE_MPSC
+#if defined( __ARM_FEATURE_LDREX ) && !defined( UTEST )
+/**
+ * @brief   **Claim a slot for a producer**
+ *
+ * Register the producer as pending and move the Reserved index one element using exclusive
+ * load/store, the store fails and the operation is repeated if another producer interrupts in
+ * between.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Index pointer to store the index claimed
+ *
+ * @retval  #TRUE if a slot was claimed otherwise #FALSE in case of full queue
+ */
+static uint8_t Producer_Enter( QueueType *Queue, uint32_t *Index )
+{
+    uint8_t result = FALSE;
+    uint8_t retry;
+    uint32_t reserved;
+
+    (void)Atomic_Add( &Queue->Pending, 1u );
+
+    do
+    {
+        retry    = FALSE;
+        reserved = __LDREXW( &Queue->Reserved );
+        if( Elements_Used( Queue, reserved, Queue->Tail ) < Queue->Elements )
+        {
+            if( __STREXW( Index_Advance( Queue, reserved, 1u ), &Queue->Reserved ) == 0u )
+            {
+                *Index = reserved;
+                result = TRUE;
+            }
+            else
+            {
+                retry = TRUE;
+            }
+        }
+        else
+        {
+            __CLREX( );
+        }
+    } while( retry == TRUE );
+
+    /*no slot, but the producers interrupted could be waiting for this one to publish*/
+    if( result == FALSE )
+    {
+        Producer_Leave( Queue );
+#ifdef QUEUE_STATISTICS
+        (void)Atomic_Add( &Queue->Dropped, 1u );
+#endif
+    }
+
+    return result;
+}
+
+/**
+ * @brief   **Release a producer and publish the elements**
+ *
+ * Decrement the pending producers, the one that reach zero moves the Head up to the Reserved
+ * index. The Head is written with an exclusive store, if another producer interrupts the store
+ * fails and the Reserved index is read again.
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ */
+static void Producer_Leave( QueueType *Queue )
+{
+    uint8_t retry;
+    uint32_t reserved;
+
+    QUEUE_BARRIER( ); /*elements shall be in memory before moving the head*/
+
+    if( Atomic_Add( &Queue->Pending, 0xFFFFFFFFu ) == 0u )
+    {
+        do
+        {
+            retry = FALSE;
+            (void)__LDREXW( &Queue->Head );
+            reserved = Queue->Reserved;
+            /*a new producer will publish his own element and the ones before him*/
+            if( Queue->Pending == 0u )
+            {
+                retry = ( __STREXW( reserved, &Queue->Head ) != 0u ) ? TRUE : FALSE;
+            }
+            else
+            {
+                __CLREX( );
+            }
+        } while( retry == TRUE );
+    }
+}
+
+/**
+ * @brief   **Atomic addition**
+ *
+ * @param Value pointer to the variable to modify
+ * @param Add   value to add, use 0xFFFFFFFF to decrement by one
+ *
+ * @retval  The new value of the variable
+ */
+static uint32_t Atomic_Add( volatile uint32_t *Value, uint32_t Add )
+{
+    uint32_t value;
+
+    do
+    {
+        value = __LDREXW( Value ) + Add;
+    } while( __STREXW( value, Value ) != 0u );
+
+    return value;
+}
+#else
+/**
+  * @defgroup Interrupt masking for the cores with no exclusive load/store, the unit test runs in a
+  * single context so no masking is needed
+  @{ */
+#ifdef UTEST
+#define MPSC_LOCK( Mask )     ( (Mask) = 0u )     /*!< no masking in unit testing */
+#define MPSC_UNLOCK( Mask )   ( (void)(Mask) )    /*!< no masking in unit testing */
+#else
+#define MPSC_LOCK( Mask )     do { (Mask) = __get_PRIMASK( ); __disable_irq( ); } while( 0 ) /*!< mask interrupts */
+#define MPSC_UNLOCK( Mask )   __set_PRIMASK( Mask ) /*!< restore previous interrupt mask */
+#endif
+/**
+  @} */
+
+/**
+ * @brief   **Claim a slot for a producer**
+ *
+ * Move the Reserved index one element and register the producer as pending, interrupts are
+ * masked just for this operation
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ * @param Index pointer to store the index claimed
+ *
+ * @retval  #TRUE if a slot was claimed otherwise #FALSE in case of full queue
+ */
+static uint8_t Producer_Enter( QueueType *Queue, uint32_t *Index )
+{
+    uint8_t result = FALSE;
+    uint32_t mask;
+
+    MPSC_LOCK( mask );
+    if( Elements_Used( Queue, Queue->Reserved, Queue->Tail ) < Queue->Elements )
+    {
+        *Index          = Queue->Reserved;
+        Queue->Reserved = Index_Advance( Queue, Queue->Reserved, 1u );
+        Queue->Pending++;
+        result = TRUE;
+    }
+    else
+    {
+        STATISTICS_DROPPED( Queue, 1u );
+    }
+    MPSC_UNLOCK( mask );
+
+    return result;
+}
+
+/**
+ * @brief   **Release a producer and publish the elements**
+ *
+ * Decrement the pending producers, the one that reach zero moves the Head up to the Reserved
+ * index, interrupts are masked just for this operation
+ *
+ * @param Queue pointer to a QueueType structure that contains queue control information
+ */
+static void Producer_Leave( QueueType *Queue )
+{
+    uint32_t mask;
+
+    QUEUE_BARRIER( ); /*elements shall be in memory before moving the head*/
+
+    MPSC_LOCK( mask );
+    Queue->Pending--;
+    if( Queue->Pending == 0u )
+    {
+        Queue->Head = Queue->Reserved;
+    }
+    MPSC_UNLOCK( mask );
+}
+#endif
+#endif
@@ -3,12 +3,45 @@
  * @brief   **Static queue algorithm**
  *
  * This is a multipourpose queue implementation capable of handle any kind of data of any size, the
- * only limitation will be the target memory. The queue does not allow overwriting data it will just
- * stop adding new elemnts if is full
+ * only limitation will be the target memory. By default the queue does not allow overwriting data it
+ * will just stop adding new elemnts if is full, optionally the queue can be set to discard the
+ * oldest element instead keeping always the newest ones (ring log), the producer never writes the
+ * Tail in this mode either, it publishes the oldest element kept and the consumer skips the ones
+ * discarded, only the elements accessed in place need the producer kept out until released
+ *
+ * The queue is lock-free for one producer and one consumer, only the producer modifies the Head and
+ * only the consumer modifies the Tail, the full and empty conditions are derived from both indexes,
+ * in this way an interrupt can write into the queue while the main loop reads from it (or the other
+ * way around) without the need of critical sections
+ *
+ * Defining QUEUE_MPSC at compile time the queue can also be written from several interrupts at the
+ * same time using Queue_WriteDataMpsc, the slots are claimed using exclusive load/store instructions
+ * on the cores that have them, or very short interrupt masked sections on the ones that do not
+ * (Cortex-M0+)
+ *
+ * Defining QUEUE_STATISTICS at compile time the queue also keeps track of the maximum number of
+ * elements stored (high-water mark) and the number of elements lost because of a full queue
+ *
+ * Defining QUEUE_NOTIFY at compile time a function can be set with Queue_SetNotify to be called
+ * each time new elements become visible to the consumer, for instance to wake up the scheduler
+ * task that drains the queue with Scheduler_NotifyTask
  */
 #ifndef QUEUE_H__
 #define QUEUE_H__
 
+/**
+  * @defgroup Memory barrier used to publish Head and Tail, it can be overwritten from the compiler
+  * command line in case of a different architecture
+  @{ */
+#ifndef QUEUE_BARRIER
+#ifdef UTEST
+#define QUEUE_BARRIER( )  __asm volatile( "" ::: "memory" )    /*!< compiler barrier for host testing */
+#else
+#define QUEUE_BARRIER( )  __asm volatile( "dmb" ::: "memory" ) /*!< ARM data memory barrier */
+#endif
+#endif
+/**
+  @} */
 
 /**
  * @brief   Queue control structure
@@ -18,16 +51,58 @@ typedef struct _QueueType
     void *Buffer;      /*!< Pointer to memory array to store data */
     uint32_t Elements; /*!< Number of elements to store queue size */
     uint8_t Size;      /*!< Size of the elements to store */
-    uint32_t Head;     /*!< Head pointer */
-    uint32_t Tail;     /*!< Tail pointer */
-    uint8_t Empty;     /*!< Flag to signal when queue is empty */
-    uint8_t Full;      /*!< flag to signal when the queue is full */
+    uint32_t Mask;     /*!< Elements - 1 when the number of elements is a power of two, otherwise zero */
+    uint8_t Overwrite; /*!< Flag to discard the oldest element when writing into a full queue */
+#ifdef QUEUE_MPSC
+    volatile uint32_t Reserved; /*!< Next Head position to claim by the multiple producers */
+    volatile uint32_t Pending;  /*!< Number of producers writing its element at this moment */
+#endif
+#ifdef QUEUE_STATISTICS
+    uint32_t HighWater; /*!< Maximum number of elements stored at the same time */
+    uint32_t Dropped;   /*!< Number of elements rejected because of full queue or discarded */
+#endif
+#ifdef QUEUE_NOTIFY
+    void (*Notify)(void); /*!< Function to call when new elements are written, NULL for none */
+#endif
+    volatile uint32_t Head; /*!< Head pointer, only written by the producer */
+    volatile uint32_t Tail; /*!< Tail pointer, only written by the consumer */
+    uint32_t Written;         /*!< Elements written since the init, only written by the producer */
+    volatile uint32_t Oldest; /*!< First element not discarded in overwrite mode, only written by the producer */
+    volatile uint32_t Read;   /*!< Elements read since the init, only written by the consumer */
 } QueueType;
 
 void Queue_Init( QueueType *Queue, void *Buffer, uint32_t Elements, uint8_t Size );
+uint8_t Queue_InitPow2( QueueType *Queue, void *Buffer, uint32_t Elements, uint8_t Size );
+void Queue_SetOverwrite( QueueType *Queue, uint8_t Overwrite );
 uint8_t Queue_WriteData( QueueType *Queue, void *Data );
 uint8_t Queue_ReadData( QueueType *Queue, void *Data );
+uint32_t Queue_WriteBlock( QueueType *Queue, void *Data, uint32_t Count );
+uint32_t Queue_ReadBlock( QueueType *Queue, void *Data, uint32_t Count );
+void *Queue_Reserve( QueueType *Queue );
+uint8_t Queue_Commit( QueueType *Queue );
+void *Queue_Peek( QueueType *Queue );
+uint8_t Queue_Release( QueueType *Queue );
+uint32_t Queue_GetWriteRegion( QueueType *Queue, void **Region );
+uint8_t Queue_AdvanceWrite( QueueType *Queue, uint32_t Count );
+uint32_t Queue_GetReadRegion( QueueType *Queue, void **Region );
+uint8_t Queue_AdvanceRead( QueueType *Queue, uint32_t Count );
 uint8_t Queue_isQueueEmpty( QueueType *Queue );
+uint8_t Queue_isQueueFull( QueueType *Queue );
+uint32_t Queue_GetCount( QueueType *Queue );
 void Queue_FlushQueue( QueueType *Queue );
 
+#ifdef QUEUE_MPSC
+uint8_t Queue_WriteDataMpsc( QueueType *Queue, void *Data );
+#endif
+
+#ifdef QUEUE_NOTIFY
+void Queue_SetNotify( QueueType *Queue, void (*Notify)(void) );
+#endif
+
+#ifdef QUEUE_STATISTICS
+uint32_t Queue_GetHighWater( QueueType *Queue );
+uint32_t Queue_GetDropped( QueueType *Queue );
+void Queue_ResetStatistics( QueueType *Queue );
+#endif
+
 #endif
@@ -0,0 +1,117 @@
+/**
+ * @file    queue_typed.h
+ * @brief   **Static typed queue generator**
+ *
+ * Header only version of the static queue where the element type and the number of elements are
+ * known at compile time, the macro QUEUE_DEFINE generates the queue control structure and a set of
+ * static inline functions specialized for the given type, so the compiler can replace the generic
+ * memcpy with a simple load or store and inline the whole operation. The number of elements shall
+ * be a power of two, Head and Tail run free and the element position is obtained with a mask.
+ *
+ * The generated queue keeps the same rules as QueueType, it is lock-free for one producer and one
+ * consumer and does not allow overwriting data.
+ *
+ * @code
+ * QUEUE_DEFINE( U8Queue, uint8_t, 128 )
+ *
+ * static U8QueueType RxQueue;
+ *
+ * U8Queue_Init( &RxQueue );
+ * (void)U8Queue_WriteData( &RxQueue, 0x55u );
+ * @endcode
+ */
+#ifndef QUEUE_TYPED_H__
+#define QUEUE_TYPED_H__
+
+#include "queue.h"
+
+/**
+  * @defgroup Boolean true and flase definitions
+  @{ */
+#ifndef FALSE
+#define FALSE 0u /*!< FALSE definition */
+#endif
+
+#ifndef TRUE
+#define TRUE 1u /*!< TRUE definition */
+#endif
+/**
+  @} */
+
+/**
+ * @brief   **Generate a typed queue**
+ *
+ * Declare the structure Name##Type and the functions Name##_Init, Name##_WriteData, Name##_ReadData,
+ * Name##_isQueueEmpty, Name##_isQueueFull and Name##_FlushQueue for a queue of Elements of DataType
+ *
+ * @param Name      prefix for the generated type and functions
+ * @param DataType  type of the elements to store
+ * @param Elements  number of elements to store, it shall be a power of two
+ */
+/* cppcheck-suppress misra-c2012-20.10 ; token pasting is neccesary to generate the functions*/
+#define QUEUE_DEFINE( Name, DataType, Elements )                                                \
+    /*compilation fails here when the number of elements is not a power of two*/               \
+    typedef char Name##_PowerOfTwo[ ( ( (Elements) & ( (Elements) - 1u ) ) == 0u ) ? 1 : -1 ]; \
+                                                                                                \
+    typedef struct _##Name##Type                                                                \
+    {                                                                                           \
+        DataType Buffer[ (Elements) ]; /*!< memory array to store data */                      \
+        volatile uint32_t Head;    /*!< Head pointer, only written by the producer */          \
+        volatile uint32_t Tail;    /*!< Tail pointer, only written by the consumer */          \
+    } Name##Type;                                                                               \
+                                                                                                \
+    static inline void Name##_Init( Name##Type *Queue )                                         \
+    {                                                                                           \
+        Queue->Head = 0u;                                                                       \
+        Queue->Tail = 0u;                                                                       \
+    }                                                                                           \
+                                                                                                \
+    static inline uint8_t Name##_WriteData( Name##Type *Queue, DataType Data )                  \
+    {                                                                                           \
+        uint8_t result = FALSE;                                                                 \
+        uint32_t head  = Queue->Head;                                                           \
+                                                                                                \
+        if( ( head - Queue->Tail ) < (Elements) )                                               \
+        {                                                                                       \
+            Queue->Buffer[ head & ( (Elements) - 1u ) ] = Data;                                 \
+            QUEUE_BARRIER( );                                                                   \
+            Queue->Head = head + 1u;                                                            \
+            result      = TRUE;                                                                 \
+        }                                                                                       \
+                                                                                                \
+        return result;                                                                          \
+    }                                                                                           \
+                                                                                                \
+    static inline uint8_t Name##_ReadData( Name##Type *Queue, DataType *Data )                  \
+    {                                                                                           \
+        uint8_t result = FALSE;                                                                 \
+        uint32_t tail  = Queue->Tail;                                                           \
+                                                                                                \
+        if( Queue->Head != tail )                                                               \
+        {                                                                                       \
+            QUEUE_BARRIER( );                                                                   \
+            *Data = Queue->Buffer[ tail & ( (Elements) - 1u ) ];                                \
+            QUEUE_BARRIER( );                                                                   \
+            Queue->Tail = tail + 1u;                                                            \
+            result      = TRUE;                                                                 \
+        }                                                                                       \
+                                                                                                \
+        return result;                                                                          \
+    }                                                                                           \
+                                                                                                \
+    static inline uint8_t Name##_isQueueEmpty( Name##Type *Queue )                              \
+    {                                                                                           \
+        return ( Queue->Head == Queue->Tail ) ? TRUE : FALSE;                                   \
+    }                                                                                           \
+                                                                                                \
+    static inline uint8_t Name##_isQueueFull( Name##Type *Queue )                               \
+    {                                                                                           \
+        return ( ( Queue->Head - Queue->Tail ) == (Elements) ) ? TRUE : FALSE;                  \
+    }                                                                                           \
+                                                                                                \
+    static inline void Name##_FlushQueue( Name##Type *Queue )                                   \
+    {                                                                                           \
+        Queue->Tail = Queue->Head;                                                              \
+    }
+
+#endif
@@ -10,11 +10,77 @@
  *
  * Software timers are an optional resource that can be use with the Schedulerm, each Timer
  * shall be register previous use, and those will decrement on each tick until reaching zero,
- * after that the Timer will stop and can be re-started.
+ * after that the Timer will stop and can be re-started. An auto-reload Timer is reloaded with its
+ * Timeout right before running its callback, the reload takes place on the same tick the Timer
+ * expires so the period does not drift no matter when the callback runs.
  *
  * The systick Timer is used trough the HAL_SysTick functions as a means of the tick counter
  * it is not advice to modify the default configuration that runs the tick each milliseconds
  *
+ * The release time of each task is kept as absolute scheduler time and the started tasks are
+ * ordered in a binary min-heap, the heap position k is stored in TaskPtr[ k ].Heap and holds the
+ * index of a task, so there is no need of extra memory. On each tick the dispatcher only runs the
+ * tasks at the top of the heap that are due, stopped tasks are out of the heap and not touched.
+ *
+ * Notified tasks are marked with a flag per task plus a flag in the scheduler, so the tasks are only
+ * scanned for notifications when at least one was notified, the notifications are checked on every
+ * pass of the main loop and not only on each tick.
+ *
+ * The tick start time is advanced by exactly one Tick on each dispatch, so when a dispatch takes
+ * longer than a tick the following ones are late. With SCHEDULER_CATCHUP_ALL the late ticks are
+ * dispatched one after another until the scheduler is on time again, any missed tick beyond the
+ * limit and all of them with the other policies are credited at once like the tickless idle
+ * ticks, a task with its release time in the past is late and runs once or it is skipped
+ * depending on the policy, in both cases the next release keeps the original task phase. Timers
+ * missing its timeout always expire on the next dispatch.
+ *
+ * In tickless mode (SCHEDULER_TICKLESS) the number of idle ticks is calculated after each dispatch
+ * and the CPU sleeps until the next tick with something to do, when it wakes up the ticks passed
+ * while sleeping are credited to the tasks and timers before dispatching.
+ *
+ * With SCHEDULER_COROUTINE a task that returns with a resume point set is suspended, it leaves
+ * its periodic release in TaskType.Pending and takes as release time the tick to continue, a
+ * suspended task stays in the heap even with no period. Once the job reaches its end the task
+ * takes back the pending release, or it leaves the heap if it is an event task. A notification
+ * continues a suspended task right away.
+ *
+ * With SCHEDULER_WORK the work queue is read on every pass of the main loop before the notified
+ * tasks, only the work already in the queue when the pass starts runs, so a work function that
+ * posts more work does not keep the loop busy. The queue is written with Queue_WriteDataMpsc
+ * when QUEUE_MPSC is defined so interrupts of any priority can post at the same time.
+ *
+ * With SCHEDULER_MAILBOX each mailbox is a single producer single consumer queue, the producer
+ * is the scheduler of one core and the consumer the scheduler of the other one, so no lock is
+ * needed between cores, the queue barrier makes the element visible before the Head. The inbox
+ * is read on every pass like the work queue and the doorbell interrupt only needs to wake up
+ * the core, a message in the inbox also keeps the tickless mode from going to sleep. The memory
+ * of the mailboxes shall be shared and not cached (or kept coherent) on both cores.
+ *
+ * With SCHEDULER_TRACE the records are written with Queue_WriteData into a queue in overwrite
+ * mode so the newest records are always kept, the records are only written from the main loop so
+ * the scheduler is the single producer, the reader of the records is the single consumer. The
+ * stamp comes from the same cycle counter used for profiling.
+ *
+ * With SCHEDULER_PRIORITY the due tasks are not run straight from the heap, they are moved to a
+ * ready list linked through TaskType.Next and sorted by the selected order, then the list is run
+ * from the beginning until the budget of cycles is consumed, the first task always runs so there is
+ * progress on every tick. A task still in the list when it is released again runs only once.
+ *
+ * With SCHEDULER_PROFILING the cycles are read from DWT->CYCCNT when the core has one, otherwise the
+ * SysTick down counter is combined with the HAL tick, both run at the core clock so the values are
+ * comparable with the number of cycles in one tick calculated from SystemCoreClock.
+ *
+ * With SCHEDULER_TIMER_LIST the running timers form a delta list linked through TimerType.Next, the
+ * Count of each timer in the list is the time left after the previous timer expires, so the time
+ * left of a timer is the sum of its Count and all the ones before it. Stopped timers are out of the
+ * list and keep in Count the time left when they were stopped.
+ *
+ * With SCHEDULER_LOAD only the cycles spent running something are counted as busy, the passes of
+ * the main loop with nothing to run are not measured so polling for the next tick counts as idle
+ * as well as sleeping in tickless mode. A period is completed on the first tick dispatch after its
+ * length in cycles has passed, so the load is the busy cycles over the cycles really elapsed. The
+ * cycle counter is 32 bits, the window shall be shorter than the time it takes to wrap around.
+ *
  */
 #include <stdint.h>
 #include "scheduler.h"
@@ -33,6 +99,53 @@
 /**
   @} */
 
+/**
+  * @defgroup Maximum number of ticks to sleep when there is nothing to dispatch in tickless mode
+  @{ */
+#ifndef SCHEDULER_IDLE_MAX
+#define SCHEDULER_IDLE_MAX  0xFFFFu /*!< maximum number of ticks to sleep in a row */
+#endif
+/**
+  @} */
+
+/**
+  * @defgroup Cycle counter needed by any of the features that measure time in CPU cycles
+  @{ */
+#if defined( SCHEDULER_PROFILING ) || defined( SCHEDULER_PRIORITY ) || defined( SCHEDULER_TRACE ) || defined( SCHEDULER_LOAD )
+#define SCHEDULER_CYCLES /*!< the cycle counter is used */
+#endif
+/**
+  @} */
+
+/**
+  * @defgroup Work queues read by the scheduler, posted from interrupts or from the other core
+  @{ */
+#if defined( SCHEDULER_WORK ) || defined( SCHEDULER_MAILBOX )
+#define SCHEDULER_DEFERRED /*!< work items are run from a queue */
+#endif
+/**
+  @} */
+
+/**
+  * @defgroup Load window used until the application sets one
+  @{ */
+#ifndef SCHEDULER_LOAD_WINDOW
+#define SCHEDULER_LOAD_WINDOW  100u /*!< window length in ms */
+#endif
+/**
+  @} */
+
+/**
+  * @defgroup Trace record logging, the call is removed when SCHEDULER_TRACE is not defined
+  @{ */
+#ifdef SCHEDULER_TRACE
+#define TRACE_EVENT( Scheduler, Event, Id )  Trace_Write( Scheduler, Event, Id ) /*!< log a trace record */
+#else
+#define TRACE_EVENT( Scheduler, Event, Id )  ( (void)0 ) /*!< trace disabled */
+#endif
+/**
+  @} */
+
 /**
   * @defgroup Boolean true and flase definitions
   @{ */
@@ -49,6 +162,58 @@
 STATIC void Inits_Dispatch( SchedulerType *Scheduler );
 STATIC void Tasks_Dispatch( SchedulerType *Scheduler );
 STATIC void Timers_Dispatch( SchedulerType *Scheduler );
+STATIC void Events_Dispatch( SchedulerType *Scheduler );
+STATIC void Task_Run( SchedulerType *Scheduler, uint8_t Index );
+#ifdef SCHEDULER_DEFERRED
+STATIC void Work_Dispatch( SchedulerType *Scheduler, QueueType *Queue );
+#endif
+#if defined( SCHEDULER_DEFERRED ) && defined( SCHEDULER_TICKLESS )
+STATIC uint8_t Work_Pending( const SchedulerType *Scheduler );
+#endif
+STATIC uint8_t Task_Before( const SchedulerType *Scheduler, uint8_t A, uint8_t B );
+STATIC void Heap_Up( SchedulerType *Scheduler, uint32_t Index );
+STATIC void Heap_Down( SchedulerType *Scheduler, uint32_t Index );
+STATIC void Heap_Insert( SchedulerType *Scheduler, uint8_t Task );
+STATIC uint8_t Heap_Remove( SchedulerType *Scheduler, uint8_t Task );
+STATIC void Heap_Rebuild( SchedulerType *Scheduler );
+#ifdef SCHEDULER_COROUTINE
+STATIC void Coroutine_Schedule( SchedulerType *Scheduler, uint8_t Task, uint16_t Resumed );
+#endif
+STATIC uint8_t Stagger_Next( const SchedulerType *Scheduler, uint8_t Task );
+STATIC uint32_t Stagger_Cost( const SchedulerType *Scheduler, uint8_t Task, uint32_t Offset );
+STATIC uint32_t Period_Gcd( uint32_t A, uint32_t B );
+#ifdef SCHEDULER_TIMER_LIST
+STATIC void Timer_Insert( SchedulerType *Scheduler, uint8_t Timer, uint32_t Time );
+STATIC uint32_t Timer_Remove( SchedulerType *Scheduler, uint8_t Timer );
+STATIC uint32_t Timer_Remaining( SchedulerType *Scheduler, uint8_t Timer );
+#endif
+#ifdef SCHEDULER_PRIORITY
+STATIC uint8_t Ready_Before( const SchedulerType *Scheduler, uint8_t A, uint8_t B );
+STATIC void Ready_Insert( SchedulerType *Scheduler, uint8_t Task );
+STATIC uint8_t Ready_Remove( SchedulerType *Scheduler, uint8_t Task );
+#endif
+#ifdef SCHEDULER_CYCLES
+STATIC void Cycles_Init( void );
+STATIC uint32_t Cycles_Get( void );
+#endif
+#ifdef SCHEDULER_LOAD
+STATIC void Load_Reset( LoadMeterType *Meter, uint32_t Length );
+STATIC void Load_Busy( SchedulerType *Scheduler, uint32_t Cycles );
+STATIC void Load_Tick( SchedulerType *Scheduler, uint32_t Start );
+STATIC void Load_Period( LoadMeterType *Meter, uint32_t Now, uint32_t Busy );
+#endif
+#ifdef SCHEDULER_TRACE
+STATIC void Trace_Write( SchedulerType *Scheduler, uint8_t Event, uint8_t Id );
+#endif
+#ifdef SCHEDULER_PROFILING
+STATIC void Profile_Reset( ProfileType *Profile );
+STATIC void Profile_Update( ProfileType *Profile, uint32_t Cycles );
+#endif
+STATIC void Ticks_Credit( SchedulerType *Scheduler, uint32_t Ticks );
+STATIC uint32_t Ticks_Missed( SchedulerType *Scheduler, uint32_t Ticks );
+#ifdef SCHEDULER_TICKLESS
+STATIC uint32_t Ticks_Idle( SchedulerType *Scheduler );
+#endif
 
 /**
  * @brief   **Initialization Scheduler Function**
@@ -67,9 +232,49 @@ void Scheduler_Init( SchedulerType *Scheduler, uint32_t TickBase, uint8_t Tasks,
     Scheduler->Timers       = Timers;
     Scheduler->TaskPtr      = TasksBuffer;
     Scheduler->TimerPtr     = TimerBuffer;
+    Scheduler->GetTick      = HAL_GetTick;
 
-    Scheduler->TasksCount  = 0u;
-    Scheduler->TimersCount = 0u;
+    Scheduler->TasksCount   = 0u;
+    Scheduler->TimersCount  = 0u;
+    Scheduler->Time         = 0u;
+    Scheduler->HeapCount    = 0u;
+    Scheduler->Catchup      = SCHEDULER_CATCHUP_ALL;
+    Scheduler->CatchupLimit = 0xFFFFFFFFu;
+    Scheduler->Missed       = 0u;
+    Scheduler->Notified     = FALSE;
+#ifdef SCHEDULER_TIMER_LIST
+    Scheduler->TimerList = 0u;
+#endif
+#ifdef SCHEDULER_PRIORITY
+    Scheduler->Order     = SCHEDULER_ORDER_PRIORITY;
+    Scheduler->ReadyList = 0u;
+    Scheduler->Budget    = 0u;
+#endif
+#ifdef SCHEDULER_WORK
+    Scheduler->WorkQueue = NULL;
+#endif
+#ifdef SCHEDULER_MAILBOX
+    Scheduler->Inbox      = NULL;
+    Scheduler->Outbox     = NULL;
+    Scheduler->Doorbell   = NULL;
+#endif
+#ifdef SCHEDULER_TRACE
+    Scheduler->TraceQueue = NULL;
+#endif
+#ifdef SCHEDULER_COROUTINE
+    Scheduler->Running   = NULL;
+#endif
+#ifdef SCHEDULER_PROFILING
+    Scheduler->TickCycles = ( SystemCoreClock / 1000u ) * TickBase;
+    Scheduler->Overruns   = 0u;
+#endif
+#ifdef SCHEDULER_LOAD
+    Load_Reset( &Scheduler->LoadSecond, SystemCoreClock );
+    Load_Reset( &Scheduler->LoadWindow, ( SystemCoreClock / 1000u ) * SCHEDULER_LOAD_WINDOW );
+#endif
+#ifdef SCHEDULER_CYCLES
+    Cycles_Init( );
+#endif
 }
 
 /**
@@ -81,29 +286,204 @@ void Scheduler_Init( SchedulerType *Scheduler, uint32_t TickBase, uint8_t Tasks,
  * by any means since it is looping inside a __while(1u)__ forever. The algorithm is pretty simple since
  * first Task to dispatch will be the first registered with the **Scheduler__RegisterTask** function
  *
+ * The tick start is advanced one tick at a time to avoid any drift, the ticks the dispatch is behind
+ * are handled with the catch-up policy before dispatching.
+ *
+ * The notified tasks run on every pass of the loop right after the tick dispatch if any, with
+ * SCHEDULER_WORK the work posted from interrupts runs right before them and with SCHEDULER_MAILBOX
+ * the work posted from the other core too.
+ *
+ * In tickless mode the function calls Scheduler_IdleHook while waiting for the next tick with
+ * something to dispatch, the ticks that passed while sleeping are credited before dispatching.
+ * The interrupts are disabled while checking for notifications and sleeping, so a notification
+ * from an interrupt is never missed right before going to sleep.
+ *
  * @param   Scheduler Scheduler control structure
  *
  */
 void Scheduler_MainFunction( SchedulerType *Scheduler )
 {
-    uint32_t tickstart = HAL_GetTick( );
+    uint32_t tickstart = Scheduler->GetTick( );
+    uint32_t ticks;
+#ifdef SCHEDULER_TICKLESS
+    uint32_t idle = 0u;
+    uint32_t credit;
+    uint32_t wake;
+#endif
+#if defined( SCHEDULER_PROFILING ) || defined( SCHEDULER_LOAD )
+    uint32_t start;
+#endif
 
     Inits_Dispatch( Scheduler );
+#ifdef SCHEDULER_LOAD
+    /*the load is measured from here*/
+    Scheduler->LoadSecond.Start = Cycles_Get( );
+    Scheduler->LoadWindow.Start = Scheduler->LoadSecond.Start;
+#endif
 
     do /* cppcheck-suppress misra-c2012-14.4 ; this is an infinite loop */
     {
         /*The configured tick has Elapsed*/
-        if( ( HAL_GetTick( ) - tickstart ) >= Scheduler->Tick )
+        if( ( Scheduler->GetTick( ) - tickstart ) >= Scheduler->Tick )
         {
-            tickstart = HAL_GetTick( ); /*volvemos a obtener los ms actuales*/
+            /*ticks behind besides the one about to be dispatched*/
+            ticks      = ( ( Scheduler->GetTick( ) - tickstart ) / Scheduler->Tick ) - 1u;
+            tickstart += Scheduler->Tick;
+#ifdef SCHEDULER_TICKLESS
+            /*credit the ticks passed while sleeping with nothing to dispatch*/
+            credit     = ( ticks < idle ) ? ticks : idle;
+            Ticks_Credit( Scheduler, credit );
+            tickstart += Scheduler->Tick * credit;
+            ticks     -= credit;
+#endif
+            /*the rest are missed ticks*/
+            tickstart += Scheduler->Tick * Ticks_Missed( Scheduler, ticks );
+#if defined( SCHEDULER_PROFILING ) || defined( SCHEDULER_LOAD )
+            start = Cycles_Get( );
+#endif
+            TRACE_EVENT( Scheduler, SCHEDULER_TRACE_TICK, 0u );
             /*Scan all registered timers*/
             Timers_Dispatch( Scheduler );
-            /*Scan all registered Task*/
+            /*Run the tasks that are due*/
             Tasks_Dispatch( Scheduler );
+#ifdef SCHEDULER_PROFILING
+            /*the whole dispatch shall fit in one tick*/
+            if( ( Cycles_Get( ) - start ) > Scheduler->TickCycles )
+            {
+                Scheduler->Overruns++;
+            }
+#endif
+#ifdef SCHEDULER_LOAD
+            Load_Tick( Scheduler, start );
+#endif
+#ifdef SCHEDULER_TICKLESS
+            /*ticks with nothing to dispatch from now on*/
+            idle = Ticks_Idle( Scheduler );
+#endif
+        }
+
+#ifdef SCHEDULER_WORK
+        /*Run the work posted since the last pass*/
+        Work_Dispatch( Scheduler, Scheduler->WorkQueue );
+#endif
+#ifdef SCHEDULER_MAILBOX
+        /*Run the work posted by the other core*/
+        Work_Dispatch( Scheduler, Scheduler->Inbox );
+#endif
+        /*Run the tasks notified since the last pass*/
+        if( Scheduler->Notified == TRUE )
+        {
+            Events_Dispatch( Scheduler );
         }
+#ifdef SCHEDULER_TICKLESS
+        else if( ( Scheduler->GetTick( ) - tickstart ) < Scheduler->Tick )
+        {
+            /*sleep until the next tick with something to dispatch unless a task was just notified*/
+            __disable_irq( );
+#ifdef SCHEDULER_DEFERRED
+            if( ( Scheduler->Notified == FALSE ) && ( Work_Pending( Scheduler ) == FALSE ) )
+#else
+            if( Scheduler->Notified == FALSE )
+#endif
+            {
+                /*the work and the events just dispatched could have started a task or a timer*/
+                idle = Ticks_Idle( Scheduler );
+                wake = ( tickstart + ( Scheduler->Tick * ( idle + 1u ) ) ) - Scheduler->GetTick( );
+                /*the tick could have elapsed since it was checked with the interrupts enabled*/
+                if( (int32_t)wake > 0 )
+                {
+                    Scheduler_IdleHook( wake );
+                }
+            }
+            __enable_irq( );
+        }
+        else
+        {
+            /*the next tick is already due*/
+        }
+#endif
     } while( FOREVER );
 }
 
+/**
+ * @brief   **Set the policy for missed ticks**
+ *
+ * Select what to do when the scheduler is behind because a dispatch took longer than the tick.
+ * With #SCHEDULER_CATCHUP_ALL up to Limit missed ticks are dispatched one after another at full
+ * speed and the rest are handled like #SCHEDULER_CATCHUP_ONCE, a Limit of zero means no late tick
+ * is dispatched at all. With #SCHEDULER_CATCHUP_ONCE the late tasks run once and with
+ * #SCHEDULER_CATCHUP_SKIP the late tasks do not run, in both cases the Limit is not used.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Policy     One of the SCHEDULER_CATCHUP_ values
+ * @param   Limit      Maximum number of missed ticks to dispatch with #SCHEDULER_CATCHUP_ALL
+ *
+ * @retval  #TRUE if the policy is valid otherwise #FALSE
+ */
+uint8_t Scheduler_SetCatchup( SchedulerType *Scheduler, uint8_t Policy, uint32_t Limit )
+{
+    uint8_t error = FALSE;
+
+    if( Policy <= SCHEDULER_CATCHUP_SKIP )
+    {
+        Scheduler->Catchup      = Policy;
+        Scheduler->CatchupLimit = Limit;
+        error                   = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Number of missed ticks**
+ *
+ * @param   Scheduler  Scheduler control structure
+ *
+ * @retval  Number of ticks that were dispatched late or not dispatched at all
+ */
+uint32_t Scheduler_GetMissedTicks( SchedulerType *Scheduler )
+{
+    return Scheduler->Missed;
+}
+
+/**
+ * @brief   **Set the tick source**
+ *
+ * Replace HAL_GetTick as the milliseconds counter of this instance, on dual core parts each
+ * scheduler can run from a counter of its own core. It shall be called before
+ * Scheduler_MainFunction.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   GetTick    Function returning a free running count of milliseconds
+ */
+void Scheduler_SetTickSource( SchedulerType *Scheduler, uint32_t (*GetTick)(void) )
+{
+    if( GetTick != NULL )
+    {
+        Scheduler->GetTick = GetTick;
+    }
+}
+
+#ifdef SCHEDULER_TICKLESS
+/**
+ * @brief   **Sleep while there is nothing to dispatch**
+ *
+ * Called from Scheduler_MainFunction in tickless mode when there is nothing to do until the time
+ * indicated, the default implementation just waits for the next interrupt (the systick wakes up
+ * the CPU every millisecond). The application can provide its own function to program a low power
+ * timer (LPTIM) with the given time, suspend the HAL tick and enter STOP mode, in that case the
+ * HAL tick shall be increased with the time slept before returning, any interrupt can wake up
+ * the CPU earlier. The function is called with the interrupts disabled, a pending interrupt
+ * still wakes up the CPU from WFI and it is served once the hook returns.
+ *
+ * @param   Time  Milliseconds until the next tick with a task or timer to dispatch
+ */
+__weak void Scheduler_IdleHook( uint32_t Time )
+{
+    (void)Time;
+    __WFI( );
+}
+#endif
+
 /**
  * @brief   **Register Tasks to Run**
  *
@@ -119,7 +499,8 @@ void Scheduler_MainFunction( SchedulerType *Scheduler )
  * @param   TaskPtr     The function that should run periodically, it is mandatory this function
  *                      do not block the CPU more than is required
  * @param   Period      The time in milliseconds the Task function should run, this value has to be
- *                      larger that the tick and multiple
+ *                      larger that the tick and multiple, a zero registers a task that only runs
+ *                      when notified with Scheduler_NotifyTask
  *
  * @return  A Task ID different from zero is returned if the Task was registered with no errors other wise the Task wont
  *          be register and the value returned will be a #FALSE
@@ -130,15 +511,29 @@ uint8_t Scheduler_RegisterTask( SchedulerType *Scheduler, void (*InitPtr)(void),
 {
     uint8_t Task = FALSE;
 
-    if( ( Scheduler->TasksCount < Scheduler->Tasks ) && ( TaskPtr != NULL ) && ( Period >= Scheduler->Tick ) && ( ( Period % Scheduler->Tick ) == 0u ) )
+    if( ( Scheduler->TasksCount < Scheduler->Tasks ) && ( TaskPtr != NULL ) && ( ( Period == 0u ) || ( ( Period >= Scheduler->Tick ) && ( ( Period % Scheduler->Tick ) == 0u ) ) ) )
     {
         Scheduler->TaskPtr[ Scheduler->TasksCount ].InitFunc  = InitPtr;
         Scheduler->TaskPtr[ Scheduler->TasksCount ].TaskFunc  = TaskPtr;
         Scheduler->TaskPtr[ Scheduler->TasksCount ].Period    = Period;
-        Scheduler->TaskPtr[ Scheduler->TasksCount ].Elapsed   = Period;
+        Scheduler->TaskPtr[ Scheduler->TasksCount ].Release   = Scheduler->Time;
         Scheduler->TaskPtr[ Scheduler->TasksCount ].StartFlag = TRUE;
+        Scheduler->TaskPtr[ Scheduler->TasksCount ].Notified  = FALSE;
+#ifdef SCHEDULER_PRIORITY
+        Scheduler->TaskPtr[ Scheduler->TasksCount ].Priority  = 0u;
+        Scheduler->TaskPtr[ Scheduler->TasksCount ].Next      = 0u;
+#endif
+#ifdef SCHEDULER_COROUTINE
+        Scheduler->TaskPtr[ Scheduler->TasksCount ].Resume    = 0u;
+        Scheduler->TaskPtr[ Scheduler->TasksCount ].Sleep     = 0u;
+#endif
+#ifdef SCHEDULER_PROFILING
+        Profile_Reset( &Scheduler->TaskPtr[ Scheduler->TasksCount ].Profile );
+#endif
         Scheduler->TasksCount++;
         Task = Scheduler->TasksCount;
+        /*the task runs on the next dispatch*/
+        Heap_Insert( Scheduler, Task );
     }
 
     return Task;
@@ -165,7 +560,20 @@ uint8_t Scheduler_StopTask( SchedulerType *Scheduler, uint8_t Task )
 
     if( ( Task > 0u ) && ( Task <= Scheduler->TasksCount ) )
     {
+        /*a stopped task is out of the heap*/
+        if( Scheduler->TaskPtr[ Task - 1u ].StartFlag == TRUE )
+        {
+            (void)Heap_Remove( Scheduler, Task );
+#ifdef SCHEDULER_PRIORITY
+            (void)Ready_Remove( Scheduler, Task );
+#endif
+        }
         Scheduler->TaskPtr[ Task - 1u ].StartFlag = FALSE;
+#ifdef SCHEDULER_COROUTINE
+        /*a stopped coroutine starts over its job*/
+        Scheduler->TaskPtr[ Task - 1u ].Resume    = 0u;
+        Scheduler->TaskPtr[ Task - 1u ].Sleep     = 0u;
+#endif
         error                                     = TRUE;
     }
     return error;
@@ -193,6 +601,15 @@ uint8_t Scheduler_StartTask( SchedulerType *Scheduler, uint8_t Task )
 
     if( ( Task > 0u ) && ( Task <= Scheduler->TasksCount ) )
     {
+        if( Scheduler->TaskPtr[ Task - 1u ].StartFlag == FALSE )
+        {
+            /*a release time already passed while stopped runs on the next dispatch*/
+            if( (int32_t)( Scheduler->TaskPtr[ Task - 1u ].Release - Scheduler->Time ) < 0 )
+            {
+                Scheduler->TaskPtr[ Task - 1u ].Release = Scheduler->Time;
+            }
+            Heap_Insert( Scheduler, Task );
+        }
         Scheduler->TaskPtr[ Task - 1u ].StartFlag = TRUE;
         error                                     = TRUE;
     }
@@ -203,14 +620,15 @@ uint8_t Scheduler_StartTask( SchedulerType *Scheduler, uint8_t Task )
  * @brief   **Update Task Period**
  *
  * This is the function that will allow to register a Task to change its periodicity from the one
- * that was set before. The function only set the __Period__ and __Elapsed__ with the new Period.
+ * that was set before. The function set the new __Period__ and the task runs on the next dispatch.
  *
  * @param   Scheduler  Scheduler control structure
  * @param   Task        The Task ID, it shall be number from 1 to n Task registered
- * @param   Period      New Period time in milliseconds
+ * @param   Period      New Period time in milliseconds, zero to make it an event task, otherwise
+ *                      it shall be a multiple of the tick
  *
- * @return  A __TRUE__ is returned if the Task was start was registered otherwise it will return a
- * __FALSE__
+ * @return  A __TRUE__ is returned if the Task was registered and the Period is valid otherwise it
+ * will return a __FALSE__
  *
  * @note the __Scheduler__ parameter shall be initialized prior to call this function
  */
@@ -218,225 +636,1844 @@ uint8_t Scheduler_PeriodTask( SchedulerType *Scheduler, uint8_t Task, uint32_t P
 {
     uint8_t error = FALSE;
 
-    if( ( Task > 0u ) && ( Task <= Scheduler->TasksCount ) )
+    if( ( Task > 0u ) && ( Task <= Scheduler->TasksCount ) && ( ( Period == 0u ) || ( ( Period >= Scheduler->Tick ) && ( ( Period % Scheduler->Tick ) == 0u ) ) ) )
     {
+        /*take the task out of the heap while its release time is changed*/
+        (void)Heap_Remove( Scheduler, Task );
         Scheduler->TaskPtr[ Task - 1u ].Period  = Period;
-        Scheduler->TaskPtr[ Task - 1u ].Elapsed = Period;
+        Scheduler->TaskPtr[ Task - 1u ].Release = Scheduler->Time;
+        if( Scheduler->TaskPtr[ Task - 1u ].StartFlag == TRUE )
+        {
+            Heap_Insert( Scheduler, Task );
+        }
+#ifdef SCHEDULER_PRIORITY
+        /*a waiting task is placed again with the new period and release time*/
+        if( Ready_Remove( Scheduler, Task ) == TRUE )
+        {
+            Ready_Insert( Scheduler, Task );
+        }
+#endif
         error                                   = TRUE;
     }
     return error;
 }
 
 /**
- * @brief   **Register Timer to use**
+ * @brief   **Set the Task offset**
  *
- * The function will register a software Timer to run with a given Timeout, the value will be
- * decremented on each tick. A Timer can not be register if the Timeout is less than the Scheduler
- * tick or a non multiple value.
+ * Delay the next release of the Task the given time from the next dispatch, the following
+ * releases keep the Task Period from there, in this way tasks with the same period can be set to
+ * run on different ticks. Usually called right after the Task is registered.
  *
  * @param   Scheduler  Scheduler control structure
- * @param   Timeout     The Timeout in milliseconds for the Timer to decrease
- * @param   CallbackPtr The callback function to run when the Timer reach zero, if no callback is
+ * @param   Task        The Task ID, it shall be number from 1 to n Task registered
+ * @param   Offset      Time in milliseconds, it shall be a multiple of the tick
  *
- * @return An id different from zero is returned if the Timer was registered with no errors other wise the Timer
- *          wont be register and the value returned will be a #FALSE
+ * @return  A #TRUE is returned if the Task was registered and the Offset is valid otherwise
+ *          it will return a #FALSE
  */
-uint8_t Scheduler_RegisterTimer( SchedulerType *Scheduler, uint32_t Timeout, void (*CallbackPtr)(void) )
+uint8_t Scheduler_OffsetTask( SchedulerType *Scheduler, uint8_t Task, uint32_t Offset )
 {
-    uint8_t Timer = FALSE;
+    uint8_t error = FALSE;
 
-    if( ( Scheduler->TimersCount < Scheduler->Timers ) && ( Timeout >= Scheduler->Tick ) && ( ( Timeout % Scheduler->Tick ) == 0u ) )
+    if( ( Task > 0u ) && ( Task <= Scheduler->TasksCount ) && ( ( Offset % Scheduler->Tick ) == 0u ) )
     {
-        Scheduler->TimerPtr[ Scheduler->TimersCount ].Timeout     = Timeout;
-        Scheduler->TimerPtr[ Scheduler->TimersCount ].Count       = 0u;
-        Scheduler->TimerPtr[ Scheduler->TimersCount ].CallbackPtr = CallbackPtr;
-        Scheduler->TimerPtr[ Scheduler->TimersCount ].StartFlag   = FALSE;
-        Scheduler->TimersCount++;
-        Timer = Scheduler->TimersCount;
+        (void)Heap_Remove( Scheduler, Task );
+        Scheduler->TaskPtr[ Task - 1u ].Release = Scheduler->Time + Offset;
+        if( Scheduler->TaskPtr[ Task - 1u ].StartFlag == TRUE )
+        {
+            Heap_Insert( Scheduler, Task );
+        }
+#ifdef SCHEDULER_PRIORITY
+        /*a waiting task is placed again with the new release time*/
+        if( Ready_Remove( Scheduler, Task ) == TRUE )
+        {
+            Ready_Insert( Scheduler, Task );
+        }
+#endif
+        error = TRUE;
     }
-
-    return Timer;
+    return error;
 }
 
 /**
- * @brief   **Get the current Timer time**
+ * @brief   **Spread the tasks releases**
  *
- * The function will return the current decremented time in milisecond for the asked Timer, if no
- * valid Timer is requested a value of zero will be returned.
+ * Select an offset for each periodic Task to reduce the number of tasks released on the same tick.
+ * Two tasks are released together at some point only if the difference of its offsets is a
+ * multiple of the greatest common divisor of its periods, so the tasks are placed one by one,
+ * starting with the shortest period, on the offset within its period that collides with the
+ * fewest tasks already placed, the earliest offset is taken in case of a tie. The releases
+ * are measured from the next dispatch and any offset set before is replaced.
  *
- * @param   Scheduler  Scheduler control structure
- * @param   Timer     The Timer to get its current time a number from 0 to SchedulerType.Timers
+ * For each of the n tasks every offset of its period P is tried against the tasks already placed,
+ * the search stops on the first offset without collisions, so it takes up to n * n * P / Tick
+ * greatest common divisor checks with P the longest period, it is intended to be called once
+ * after all the tasks are registered and before the scheduler starts.
  *
- * @return A value betwen zero and the Timeout registered for the requested Timer
+ * @param   Scheduler  Scheduler control structure
  */
-uint32_t Scheduler_GetTimer( SchedulerType *Scheduler, uint8_t Timer )
+void Scheduler_StaggerTasks( SchedulerType *Scheduler )
 {
-    uint32_t Time = 0u;
+    uint8_t task = Stagger_Next( Scheduler, 0u );
+    uint32_t offset;
+    uint32_t best;
+    uint32_t cost;
+    uint32_t least;
 
-    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
+    while( task != 0u )
     {
-        Time = Scheduler->TimerPtr[ Timer - 1u ].Count;
+        best  = 0u;
+        least = 0xFFFFFFFFu;
+        /*no offset can beat one without collisions*/
+        for( offset = 0u; ( offset < Scheduler->TaskPtr[ task - 1u ].Period ) && ( least > 0u ); offset += Scheduler->Tick )
+        {
+            cost = Stagger_Cost( Scheduler, task, offset );
+            if( cost < least )
+            {
+                least = cost;
+                best  = offset;
+            }
+        }
+        Scheduler->TaskPtr[ task - 1u ].Release = Scheduler->Time + best;
+        task = Stagger_Next( Scheduler, task );
     }
 
-    return Time;
+    /*all the release times changed*/
+    Heap_Rebuild( Scheduler );
+#ifdef SCHEDULER_PRIORITY
+    (void)Scheduler_SetOrder( Scheduler, Scheduler->Order );
+#endif
 }
 
+#ifdef SCHEDULER_WORK
 /**
- * @brief   **Set a new Timer Timeout value**
+ * @brief   **Set the deferred work queue**
  *
- * The function will set a new Timeout for an already registered Timer, if no valid Timer or a valid
- * Timeout is set the function wont take any effect, also this function wont stop the Timer Count
- * neither start the Count.
+ * Initialize the queue to hold the work posted from interrupts using the given buffer, the queue
+ * is only used by the scheduler and shall not be written or read by the application.
  *
  * @param   Scheduler  Scheduler control structure
- * @param   Timer     The Timer to get its current time a number from 0 to Scheduler_HandleTypeDef.timers
- * @param   Timeout     The new Timer Timeout value to decrement
- *
- * @retval  #TRUE if the Timer was reloaded otherwise #FALSE
+ * @param   Queue      Queue control structure to use
+ * @param   Buffer     Memory array to store the work items
+ * @param   Elements   Number of work items the buffer can store
  */
-uint8_t Scheduler_ReloadTimer( SchedulerType *Scheduler, uint8_t Timer, uint32_t Timeout )
+void Scheduler_InitWork( SchedulerType *Scheduler, QueueType *Queue, WorkType *Buffer, uint32_t Elements )
 {
-    uint8_t error = FALSE;
-
-    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
-    {
-        Scheduler->TimerPtr[ Timer - 1u ].Timeout = Timeout;
-        /*reload current Count if Timer is active*/
-        if( Scheduler->TimerPtr[ Timer - 1u ].StartFlag == TRUE )
-        {
-            Scheduler->TimerPtr[ Timer - 1u ].Count = Scheduler->TimerPtr[ Timer - 1u ].Timeout;
-        }
-        error = TRUE;
-    }
-    return error;
+    Queue_Init( Queue, Buffer, Elements, (uint8_t)sizeof( WorkType ) );
+    Scheduler->WorkQueue = Queue;
 }
 
 /**
- * @brief   **Start decrementing the Timer Count**
+ * @brief   **Post work to run at task level**
  *
- * The function will start the Timer decrement Count on each tick only if the Timer is registered,
- * This is the only mechanism to start a Timer, when a Timer reach its Count to zero the Timer will
- * stop nad only this function can re-start the Count again.
+ * Intended to be called from an interrupt, the function and context are stored in the work queue
+ * and the function runs from the scheduler main loop on its next pass. Without QUEUE_MPSC only one
+ * interrupt, or interrupts that cannot preempt each other, shall post work.
  *
  * @param   Scheduler  Scheduler control structure
- * @param   Timer     The Timer to start, any number from 0 to Scheduler_HandleTypeDef.timers
+ * @param   Func       Function to run
+ * @param   Context    Value to pass to the function
  *
- * @retval  #TRUE if the Timer was started otherwise #FALSE
+ * @retval  #TRUE if the work was posted, #FALSE if the queue is full or it was not set
  */
-uint8_t Scheduler_StartTimer( SchedulerType *Scheduler, uint8_t Timer )
+uint8_t Scheduler_PostWork( SchedulerType *Scheduler, void (*Func)(uint32_t Context), uint32_t Context )
 {
     uint8_t error = FALSE;
+    WorkType work;
 
-    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
+    if( ( Scheduler->WorkQueue != NULL ) && ( Func != NULL ) )
     {
-        Scheduler->TimerPtr[ Timer - 1u ].Count     = Scheduler->TimerPtr[ Timer - 1u ].Timeout;
-        Scheduler->TimerPtr[ Timer - 1u ].StartFlag = TRUE;
-        error                                       = TRUE;
+        work.Func    = Func;
+        work.Context = Context;
+#ifdef QUEUE_MPSC
+        error = Queue_WriteDataMpsc( Scheduler->WorkQueue, &work );
+#else
+        error = Queue_WriteData( Scheduler->WorkQueue, &work );
+#endif
     }
     return error;
 }
+#endif
 
+#ifdef SCHEDULER_MAILBOX
 /**
- * @brief   **Stop decrementing the Timer Count**
+ * @brief   **Initialize a mailbox**
  *
- * The function will stop the Timer decrement Count on each tick only if the Timer is registered,
- * This is the only mechanism to stop a Timer. The function only set the flag StartFlag to FALSE.
+ * Initialize the queue in shared memory used by one instance to post work to the other, it shall
+ * be called only once by one of the cores before any of the schedulers use the mailbox. With the
+ * data cache enabled (Cortex-M7) the queue and the buffer shall be in non-cacheable memory, set by
+ * the linker placement or by an MPU region, a dmb is not enough to make the writes visible to the
+ * other core.
+ *
+ * @param   Mailbox   Queue control structure in shared non-cacheable memory
+ * @param   Buffer    Memory array in shared non-cacheable memory to store the work items
+ * @param   Elements  Number of work items the buffer can store
+ */
+void Scheduler_InitMailbox( QueueType *Mailbox, WorkType *Buffer, uint32_t Elements )
+{
+    Queue_Init( Mailbox, Buffer, Elements, (uint8_t)sizeof( WorkType ) );
+}
+
+/**
+ * @brief   **Set the mailboxes of the instance**
+ *
+ * The inbox of this instance shall be the outbox of the other one and the other way around, any
+ * of them can be NULL if the work only goes in one direction.
  *
  * @param   Scheduler  Scheduler control structure
- * @param   Timer     The Timer to start, any number from 0 to Scheduler_HandleTypeDef.timers
+ * @param   Inbox      Mailbox to read the work posted by the other instance
+ * @param   Outbox     Mailbox to post work to the other instance
+ * @param   Doorbell   Function to interrupt the other core once a work is posted, NULL for none
+ */
+void Scheduler_SetMailbox( SchedulerType *Scheduler, QueueType *Inbox, QueueType *Outbox, void (*Doorbell)(void) )
+{
+    Scheduler->Inbox    = Inbox;
+    Scheduler->Outbox   = Outbox;
+    Scheduler->Doorbell = Doorbell;
+}
+
+/**
+ * @brief   **Post work to the other core**
  *
- * @return  A __TRUE__ is returned if the stoped Timer was registered otherwise it will return a
- * __FALSE__
+ * The function and context are written into the outbox and the doorbell is rung, the function
+ * runs from the main loop of the other scheduler, so its address shall be valid on the other
+ * core. Only the tasks of this instance shall post, the outbox has a single producer.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Func       Function to run on the other core
+ * @param   Context    Value to pass to the function
+ *
+ * @retval  #TRUE if the work was posted, #FALSE if the outbox is full or it was not set
  */
-uint8_t Scheduler_StopTimer( SchedulerType *Scheduler, uint8_t Timer )
+uint8_t Scheduler_PostRemote( SchedulerType *Scheduler, void (*Func)(uint32_t Context), uint32_t Context )
 {
     uint8_t error = FALSE;
+    WorkType work;
 
-    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
+    if( ( Scheduler->Outbox != NULL ) && ( Func != NULL ) )
     {
-        Scheduler->TimerPtr[ Timer - 1u ].StartFlag = FALSE;
-        error                                       = TRUE;
+        work.Func    = Func;
+        work.Context = Context;
+        error        = Queue_WriteData( Scheduler->Outbox, &work );
+        if( ( error == TRUE ) && ( Scheduler->Doorbell != NULL ) )
+        {
+            Scheduler->Doorbell( );
+        }
     }
     return error;
 }
+#endif
 
+#ifdef SCHEDULER_TRACE
 /**
- * @brief   **Run the Task initial functions**
+ * @brief   **Set the trace queue**
+ *
+ * Initialize the queue to log the trace records using the given buffer, the queue is set in
+ * overwrite mode so the oldest records are discarded when it is full. The records are read with
+ * Queue_ReadData or Queue_ReadBlock, for instance to copy them into a UART DMA buffer from a task.
+ * The buffer size in bytes is Elements times eight.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Queue      Queue control structure to use
+ * @param   Buffer     Memory array to store the records
+ * @param   Elements   Number of records the buffer can store
+ */
+void Scheduler_InitTrace( SchedulerType *Scheduler, QueueType *Queue, TraceType *Buffer, uint32_t Elements )
+{
+    Queue_Init( Queue, Buffer, Elements, (uint8_t)sizeof( TraceType ) );
+    Queue_SetOverwrite( Queue, TRUE );
+    Scheduler->TraceQueue = Queue;
+}
+
+#ifdef SCHEDULER_TRACE_ITM
+/**
+ * @brief   **Send the trace records over SWO**
+ *
+ * Write the records logged so far to the ITM stimulus port 0 as two 32-bit words each, the
+ * function waits for the port to be ready so it is intended to be called from the idle task or
+ * a low rate task. Nothing is sent if the port is not enabled by the debugger.
+ *
+ * @param   Scheduler  Scheduler control structure
+ *
+ * @retval  Number of records sent
+ */
+uint32_t Scheduler_FlushTraceItm( SchedulerType *Scheduler )
+{
+    uint32_t sent = 0u;
+    TraceType record;
+
+    if( ( Scheduler->TraceQueue != NULL ) && ( ( ITM->TCR & ITM_TCR_ITMENA_Msk ) != 0u ) && ( ( ITM->TER & 1u ) != 0u ) )
+    {
+        while( Queue_ReadData( Scheduler->TraceQueue, &record ) == TRUE )
+        {
+            while( ITM->PORT[ 0u ].u32 == 0u )
+            {
+                /*wait for the stimulus port*/
+            }
+            ITM->PORT[ 0u ].u32 = record.Stamp;
+            while( ITM->PORT[ 0u ].u32 == 0u )
+            {
+                /*wait for the stimulus port*/
+            }
+            ITM->PORT[ 0u ].u32 = (uint32_t)record.Time | ( (uint32_t)record.Event << 16u ) | ( (uint32_t)record.Id << 24u );
+            sent++;
+        }
+    }
+    return sent;
+}
+#endif
+#endif
+
+/**
+ * @brief   **Notify a Task**
+ *
+ * Mark the Task to run on the next pass of the scheduler no matter its period, several
+ * notifications before the Task runs are counted as one. The function only writes two flags so
+ * it can be called from interrupts, notifications to a stopped Task are discarded.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task        The Task ID, it shall be number from 1 to n Task registered
+ *
+ * @return  A #TRUE is returned if the Task is registered otherwise it will return a #FALSE
+ */
+uint8_t Scheduler_NotifyTask( SchedulerType *Scheduler, uint8_t Task )
+{
+    uint8_t error = FALSE;
+
+    if( ( Task > 0u ) && ( Task <= Scheduler->TasksCount ) )
+    {
+        Scheduler->TaskPtr[ Task - 1u ].Notified = TRUE;
+        Scheduler->Notified                      = TRUE; /*set last, it is cleared first*/
+        error                                    = TRUE;
+    }
+    return error;
+}
+
+#ifdef SCHEDULER_PRIORITY
+/**
+ * @brief   **Set the Task priority**
+ *
+ * The priority is used when the order is #SCHEDULER_ORDER_PRIORITY, tasks with the same priority
+ * run in registration order. By default all tasks have priority zero.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task        The Task ID, it shall be number from 1 to n Task registered
+ * @param   Priority    New priority, zero is the highest
+ *
+ * @return  A #TRUE is returned if the Task is registered otherwise it will return a #FALSE
+ */
+uint8_t Scheduler_PriorityTask( SchedulerType *Scheduler, uint8_t Task, uint8_t Priority )
+{
+    uint8_t error = FALSE;
+
+    if( ( Task > 0u ) && ( Task <= Scheduler->TasksCount ) )
+    {
+        Scheduler->TaskPtr[ Task - 1u ].Priority = Priority;
+        /*a waiting task is placed again with its new priority*/
+        if( Ready_Remove( Scheduler, Task ) == TRUE )
+        {
+            Ready_Insert( Scheduler, Task );
+        }
+        error = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Select the order to run the tasks due on the same tick**
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Order      #SCHEDULER_ORDER_PRIORITY (default), #SCHEDULER_ORDER_RM or #SCHEDULER_ORDER_EDF
+ *
+ * @return  A #TRUE is returned if the order is valid otherwise it will return a #FALSE
+ */
+uint8_t Scheduler_SetOrder( SchedulerType *Scheduler, uint8_t Order )
+{
+    uint8_t error = FALSE;
+    uint8_t ready;
+    uint8_t next;
+
+    if( Order <= SCHEDULER_ORDER_EDF )
+    {
+        Scheduler->Order = Order;
+        /*sort again the tasks already waiting*/
+        ready                = Scheduler->ReadyList;
+        Scheduler->ReadyList = 0u;
+        while( ready != 0u )
+        {
+            next = Scheduler->TaskPtr[ ready - 1u ].Next;
+            Ready_Insert( Scheduler, ready );
+            ready = next;
+        }
+        error = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Set the budget of cycles per tick**
+ *
+ * Once the ready tasks run on a tick have taken more than the given number of cycles the rest
+ * are deferred to the next tick, the first ready task always runs. The cycles are counted with
+ * the same counter used for profiling, the DWT cycle counter or the SysTick.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Cycles     CPU cycles per tick, zero for no limit (default)
+ */
+void Scheduler_SetBudget( SchedulerType *Scheduler, uint32_t Cycles )
+{
+    Scheduler->Budget = Cycles;
+}
+#endif
+
+/**
+ * @brief   **Register Timer to use**
+ *
+ * The function will register a software Timer to run with a given Timeout, the value will be
+ * decremented on each tick. A Timer can not be register if the Timeout is less than the Scheduler
+ * tick or a non multiple value.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timeout     The Timeout in milliseconds for the Timer to decrease
+ * @param   CallbackPtr The callback function to run when the Timer reach zero, if no callback is
+ *
+ * @return An id different from zero is returned if the Timer was registered with no errors other wise the Timer
+ *          wont be register and the value returned will be a #FALSE
+ */
+uint8_t Scheduler_RegisterTimer( SchedulerType *Scheduler, uint32_t Timeout, void (*CallbackPtr)(void) )
+{
+    uint8_t Timer = FALSE;
+
+    if( ( Scheduler->TimersCount < Scheduler->Timers ) && ( Timeout >= Scheduler->Tick ) && ( ( Timeout % Scheduler->Tick ) == 0u ) )
+    {
+        Scheduler->TimerPtr[ Scheduler->TimersCount ].Timeout     = Timeout;
+        Scheduler->TimerPtr[ Scheduler->TimersCount ].Count       = 0u;
+        Scheduler->TimerPtr[ Scheduler->TimersCount ].CallbackPtr = CallbackPtr;
+        Scheduler->TimerPtr[ Scheduler->TimersCount ].StartFlag   = FALSE;
+        Scheduler->TimerPtr[ Scheduler->TimersCount ].AutoReload  = FALSE;
+#ifdef SCHEDULER_PROFILING
+        Profile_Reset( &Scheduler->TimerPtr[ Scheduler->TimersCount ].Profile );
+#endif
+        Scheduler->TimersCount++;
+        Timer = Scheduler->TimersCount;
+    }
+
+    return Timer;
+}
+
+/**
+ * @brief   **Get the current Timer time**
+ *
+ * The function will return the current decremented time in milisecond for the asked Timer, if no
+ * valid Timer is requested a value of zero will be returned.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer     The Timer to get its current time a number from 0 to SchedulerType.Timers
+ *
+ * @return A value betwen zero and the Timeout registered for the requested Timer
+ */
+uint32_t Scheduler_GetTimer( SchedulerType *Scheduler, uint8_t Timer )
+{
+    uint32_t Time = 0u;
+
+    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
+    {
+#ifdef SCHEDULER_TIMER_LIST
+        if( Scheduler->TimerPtr[ Timer - 1u ].StartFlag == TRUE )
+        {
+            Time = Timer_Remaining( Scheduler, Timer );
+        }
+        else
+#endif
+        {
+            Time = Scheduler->TimerPtr[ Timer - 1u ].Count;
+        }
+    }
+
+    return Time;
+}
+
+/**
+ * @brief   **Set a new Timer Timeout value**
+ *
+ * The function will set a new Timeout for an already registered Timer, if no valid Timer or a valid
+ * Timeout is set the function wont take any effect, the Timeout shall be a multiple of the tick
+ * like in Scheduler_RegisterTimer, also this function wont stop the Timer Count neither start the
+ * Count.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer     The Timer to get its current time a number from 0 to Scheduler_HandleTypeDef.timers
+ * @param   Timeout     The new Timer Timeout value to decrement
+ *
+ * @retval  #TRUE if the Timer was reloaded otherwise #FALSE
+ */
+uint8_t Scheduler_ReloadTimer( SchedulerType *Scheduler, uint8_t Timer, uint32_t Timeout )
+{
+    uint8_t error = FALSE;
+
+    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) && ( Timeout >= Scheduler->Tick ) && ( ( Timeout % Scheduler->Tick ) == 0u ) )
+    {
+        Scheduler->TimerPtr[ Timer - 1u ].Timeout = Timeout;
+        /*reload current Count if Timer is active*/
+        if( Scheduler->TimerPtr[ Timer - 1u ].StartFlag == TRUE )
+        {
+#ifdef SCHEDULER_TIMER_LIST
+            (void)Timer_Remove( Scheduler, Timer );
+            Timer_Insert( Scheduler, Timer, Timeout );
+#else
+            Scheduler->TimerPtr[ Timer - 1u ].Count = Scheduler->TimerPtr[ Timer - 1u ].Timeout;
+#endif
+        }
+        error = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Start decrementing the Timer Count**
+ *
+ * The function will start the Timer decrement Count on each tick only if the Timer is registered,
+ * This is the only mechanism to start a Timer, when a Timer reach its Count to zero the Timer will
+ * stop nad only this function can re-start the Count again.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer     The Timer to start, any number from 0 to Scheduler_HandleTypeDef.timers
+ *
+ * @retval  #TRUE if the Timer was started otherwise #FALSE
+ */
+uint8_t Scheduler_StartTimer( SchedulerType *Scheduler, uint8_t Timer )
+{
+    uint8_t error = FALSE;
+
+    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
+    {
+#ifdef SCHEDULER_TIMER_LIST
+        /*a running timer is restarted*/
+        if( Scheduler->TimerPtr[ Timer - 1u ].StartFlag == TRUE )
+        {
+            (void)Timer_Remove( Scheduler, Timer );
+        }
+        Timer_Insert( Scheduler, Timer, Scheduler->TimerPtr[ Timer - 1u ].Timeout );
+#else
+        Scheduler->TimerPtr[ Timer - 1u ].Count     = Scheduler->TimerPtr[ Timer - 1u ].Timeout;
+#endif
+        Scheduler->TimerPtr[ Timer - 1u ].StartFlag = TRUE;
+        error                                       = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Stop decrementing the Timer Count**
+ *
+ * The function will stop the Timer decrement Count on each tick only if the Timer is registered,
+ * This is the only mechanism to stop a Timer. The function only set the flag StartFlag to FALSE.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer     The Timer to start, any number from 0 to Scheduler_HandleTypeDef.timers
+ *
+ * @return  A __TRUE__ is returned if the stoped Timer was registered otherwise it will return a
+ * __FALSE__
+ */
+uint8_t Scheduler_StopTimer( SchedulerType *Scheduler, uint8_t Timer )
+{
+    uint8_t error = FALSE;
+
+    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
+    {
+#ifdef SCHEDULER_TIMER_LIST
+        /*keep the time left while the timer is out of the list*/
+        if( Scheduler->TimerPtr[ Timer - 1u ].StartFlag == TRUE )
+        {
+            Scheduler->TimerPtr[ Timer - 1u ].Count = Timer_Remove( Scheduler, Timer );
+        }
+#endif
+        Scheduler->TimerPtr[ Timer - 1u ].StartFlag = FALSE;
+        error                                       = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Select the Timer auto-reload mode**
+ *
+ * With the auto-reload mode the Timer is not stopped when its Count reaches zero, it is reloaded
+ * with its Timeout and keeps running until Scheduler_StopTimer is called, the callback runs on each
+ * expiration. A Timer that misses its expiration because of credited ticks (see the catch-up
+ * policies) expires once on the next dispatch and it is reloaded from there.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer      The Timer ID, any number from 1 to n Timers registered
+ * @param   AutoReload #TRUE to reload the Timer when it expires, #FALSE to stop it (default)
+ *
+ * @retval  #TRUE if the Timer is registered otherwise #FALSE
+ */
+uint8_t Scheduler_AutoReloadTimer( SchedulerType *Scheduler, uint8_t Timer, uint8_t AutoReload )
+{
+    uint8_t error = FALSE;
+
+    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
+    {
+        Scheduler->TimerPtr[ Timer - 1u ].AutoReload = AutoReload;
+        error                                        = TRUE;
+    }
+    return error;
+}
+
+#ifdef SCHEDULER_PROFILING
+/**
+ * @brief   **Get the execution time profile of a task**
+ *
+ * Copy the cycles measured for the task function, the average can be calculated as
+ * Total / Runs when Runs is different from zero.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task       The Task ID, it shall be number from 1 to n Task registered
+ * @param   Profile    Pointer to the structure where the profile is copied
+ *
+ * @retval  #TRUE if the Task is registered otherwise #FALSE
+ */
+uint8_t Scheduler_GetTaskProfile( SchedulerType *Scheduler, uint8_t Task, ProfileType *Profile )
+{
+    uint8_t error = FALSE;
+
+    if( ( Task > 0u ) && ( Task <= Scheduler->TasksCount ) )
+    {
+        *Profile = Scheduler->TaskPtr[ Task - 1u ].Profile;
+        error    = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Get the execution time profile of a timer callback**
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer      The Timer ID, it shall be number from 1 to n Timers registered
+ * @param   Profile    Pointer to the structure where the profile is copied
+ *
+ * @retval  #TRUE if the Timer is registered otherwise #FALSE
+ */
+uint8_t Scheduler_GetTimerProfile( SchedulerType *Scheduler, uint8_t Timer, ProfileType *Profile )
+{
+    uint8_t error = FALSE;
+
+    if( ( Timer > 0u ) && ( Timer <= Scheduler->TimersCount ) )
+    {
+        *Profile = Scheduler->TimerPtr[ Timer - 1u ].Profile;
+        error    = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Number of overrun ticks**
+ *
+ * @param   Scheduler  Scheduler control structure
+ *
+ * @retval  Number of ticks where running the timers and tasks took longer than the tick
+ */
+uint32_t Scheduler_GetOverruns( SchedulerType *Scheduler )
+{
+    return Scheduler->Overruns;
+}
+#endif
+
+#ifdef SCHEDULER_LOAD
+/**
+ * @brief   **Set the load window**
+ *
+ * Set the length of the window to measure the load besides the one second measurement, the new
+ * length takes place once the window in progress is completed.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Window     Window length in milliseconds
+ *
+ * @retval  #TRUE if the window is not zero and its cycles fit in 32 bits otherwise #FALSE
+ */
+uint8_t Scheduler_SetLoadWindow( SchedulerType *Scheduler, uint32_t Window )
+{
+    uint8_t error = FALSE;
+
+    if( ( Window > 0u ) && ( Window <= ( 0xFFFFFFFFu / ( SystemCoreClock / 1000u ) ) ) )
+    {
+        Scheduler->LoadWindow.Length = ( SystemCoreClock / 1000u ) * Window;
+        error                        = TRUE;
+    }
+    return error;
+}
+
+/**
+ * @brief   **Get the CPU load**
+ *
+ * The values are the ones of the last second and the last window completed, they are zero until
+ * the first period is completed.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Load       Structure to store the load
+ */
+void Scheduler_GetLoad( SchedulerType *Scheduler, LoadType *Load )
+{
+    Load->Second = Scheduler->LoadSecond.Load;
+    Load->Window = Scheduler->LoadWindow.Load;
+    Load->Peak   = Scheduler->LoadWindow.MaxTick;
+    Load->Idle   = Scheduler->LoadWindow.Idle;
+}
+#endif
+
+/**
+ * @brief   **Run the Task initial functions**
+ *
+ * The function will stop the Timer decrement Count on each tick only if the Timer is registered,
+ * This is the only mechanism to stop a Timer. The function only set the flag StartFlag to FALSE.
+ *
+ * @param   Scheduler  Scheduler control structure
+ */
+STATIC void Inits_Dispatch( SchedulerType *Scheduler )
+{
+    for( uint8_t i = 0u; i < Scheduler->TasksCount; i++ )
+    {
+        /*Only run those init functions truly registered*/
+        if( Scheduler->TaskPtr[ i ].InitFunc != NULL )
+        {
+            /*Init registered Task*/
+            TRACE_EVENT( Scheduler, SCHEDULER_TRACE_INIT_START, i + 1u );
+            Scheduler->TaskPtr[ i ].InitFunc( );
+            TRACE_EVENT( Scheduler, SCHEDULER_TRACE_INIT_END, i + 1u );
+        }
+    }
+}
+
+/**
+ * @brief   **Run the tasks that are due**
+ *
+ * The task at the top of the heap is the next one to run, while its release time has been reached
+ * the task gets its next release time one Period later, it is moved down in the heap and then runs.
+ * A task with a release time before the current tick is late, its release time moves forward by
+ * whole periods to the first one after the current tick and it runs unless the catch-up policy
+ * is #SCHEDULER_CATCHUP_SKIP.
+ *
+ * With SCHEDULER_PRIORITY the due tasks are inserted in the ready list instead, and once all of
+ * them are released the list runs in order while there are cycles left in the budget.
+ * The scheduler time is advanced one tick before running the tasks, so the tasks that are started
+ * or updated from another task run on the next dispatch.
+ *
+ * @param   Scheduler  Scheduler control structure
+ */
+STATIC void Tasks_Dispatch( SchedulerType *Scheduler )
+{
+    uint32_t now = Scheduler->Time;
+    TaskType *task;
+    uint8_t index;
+    uint8_t run;
+#ifdef SCHEDULER_PRIORITY
+    uint32_t start;
+#endif
+
+    Scheduler->Time += Scheduler->Tick;
+
+    /*Only the tasks at the top of the heap with its release time reached are due*/
+    while( ( Scheduler->HeapCount > 0u ) && ( (int32_t)( now - Scheduler->TaskPtr[ Scheduler->TaskPtr[ 0u ].Heap ].Release ) >= 0 ) )
+    {
+        index = Scheduler->TaskPtr[ 0u ].Heap;
+        task  = &Scheduler->TaskPtr[ index ];
+        run   = TRUE;
+#ifdef SCHEDULER_COROUTINE
+        if( task->Resume != 0u )
+        {
+            /*a suspended coroutine continues, it gets its next release time once it runs*/
+            task->Release = Scheduler->Time;
+        }
+        else
+#endif
+        {
+            /*a late task skips the releases already passed keeping its phase*/
+            if( (int32_t)( now - task->Release ) > 0 )
+            {
+                task->Release += ( ( now - task->Release ) / task->Period ) * task->Period;
+                run            = ( ( Scheduler->Catchup != SCHEDULER_CATCHUP_SKIP ) || ( task->Release == now ) ) ? TRUE : FALSE;
+            }
+            task->Release += task->Period;
+        }
+        Heap_Down( Scheduler, 0u );
+        if( run == TRUE )
+        {
+#ifdef SCHEDULER_PRIORITY
+            /*a task still waiting from a previous tick is ready only once*/
+            (void)Ready_Remove( Scheduler, index + 1u );
+            Ready_Insert( Scheduler, index + 1u );
+#else
+            /*Run Task*/
+            Task_Run( Scheduler, index );
+#endif
+        }
+    }
+
+#ifdef SCHEDULER_PRIORITY
+    /*Run the ready tasks in order, the rest wait for the next tick once the budget is consumed*/
+    start = Cycles_Get( );
+    while( Scheduler->ReadyList != 0u )
+    {
+        task                 = &Scheduler->TaskPtr[ Scheduler->ReadyList - 1u ];
+        index                = Scheduler->ReadyList - 1u;
+        Scheduler->ReadyList = task->Next;
+        Task_Run( Scheduler, index );
+        if( ( Scheduler->Budget > 0u ) && ( ( Cycles_Get( ) - start ) >= Scheduler->Budget ) )
+        {
+            break;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief   **Run one task**
+ *
+ * With SCHEDULER_COROUTINE the task is placed again in the heap if it was suspended or it has
+ * been suspended by this run.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Index      Index of the task to run in the task buffer
+ */
+STATIC void Task_Run( SchedulerType *Scheduler, uint8_t Index )
+{
+    TaskType *task = &Scheduler->TaskPtr[ Index ];
+#ifdef SCHEDULER_COROUTINE
+    uint16_t resumed = task->Resume;
+#endif
+#ifdef SCHEDULER_PROFILING
+    uint32_t start = Cycles_Get( );
+#endif
+
+#ifdef SCHEDULER_COROUTINE
+    Scheduler->Running = task;
+#endif
+    TRACE_EVENT( Scheduler, SCHEDULER_TRACE_TASK_START, Index + 1u );
+    task->TaskFunc( );
+    TRACE_EVENT( Scheduler, SCHEDULER_TRACE_TASK_END, Index + 1u );
+#ifdef SCHEDULER_PROFILING
+    Profile_Update( &task->Profile, Cycles_Get( ) - start );
+#endif
+#ifdef SCHEDULER_COROUTINE
+    Coroutine_Schedule( Scheduler, Index + 1u, resumed );
+#endif
+}
+
+/**
+ * @brief   **Run the notified tasks**
+ *
+ * The scheduler flag is cleared before looking for the tasks and each task flag is cleared before
+ * running it, so a notification arriving meanwhile is kept for the next pass. Tasks run in
+ * registration order.
+ *
+ * @param   Scheduler  Scheduler control structure
+ */
+STATIC void Events_Dispatch( SchedulerType *Scheduler )
+{
+#ifdef SCHEDULER_LOAD
+    uint32_t start = Cycles_Get( );
+#endif
+    Scheduler->Notified = FALSE;
+
+    for( uint8_t i = 0u; i < Scheduler->TasksCount; i++ )
+    {
+        if( Scheduler->TaskPtr[ i ].Notified == TRUE )
+        {
+            Scheduler->TaskPtr[ i ].Notified = FALSE;
+            /*Only run those tasks that are started*/
+            if( Scheduler->TaskPtr[ i ].StartFlag == TRUE )
+            {
+                Task_Run( Scheduler, i );
+            }
+        }
+    }
+#ifdef SCHEDULER_LOAD
+    Load_Busy( Scheduler, Cycles_Get( ) - start );
+#endif
+}
+
+#ifdef SCHEDULER_DEFERRED
+/**
+ * @brief   **Run the posted work**
+ *
+ * Only the work already posted when the function is called runs, the work posted meanwhile
+ * waits for the next pass.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Queue      Queue with the work to run, NULL if it is not set
+ */
+STATIC void Work_Dispatch( SchedulerType *Scheduler, QueueType *Queue )
+{
+    WorkType work;
+    uint32_t count;
+#ifdef SCHEDULER_LOAD
+    uint32_t start = 0u;
+    uint32_t posted;
+#else
+    (void)Scheduler; /*only needed to count the load*/
+#endif
+
+    if( Queue != NULL )
+    {
+        count = Queue_GetCount( Queue );
+#ifdef SCHEDULER_LOAD
+        /*a pass with no work is idle time and it is not measured*/
+        posted = count;
+        if( posted > 0u )
+        {
+            start = Cycles_Get( );
+        }
+#endif
+        while( ( count > 0u ) && ( Queue_ReadData( Queue, &work ) == TRUE ) )
+        {
+            work.Func( work.Context );
+            count--;
+        }
+#ifdef SCHEDULER_LOAD
+        if( posted > 0u )
+        {
+            Load_Busy( Scheduler, Cycles_Get( ) - start );
+        }
+#endif
+    }
+}
+#endif
+
+#if defined( SCHEDULER_DEFERRED ) && defined( SCHEDULER_TICKLESS )
+/**
+ * @brief   **Check for posted work**
+ *
+ * @param   Scheduler  Scheduler control structure
+ *
+ * @retval  #TRUE if there is work waiting to run otherwise #FALSE
+ */
+STATIC uint8_t Work_Pending( const SchedulerType *Scheduler )
+{
+    uint8_t pending = FALSE;
+
+#ifdef SCHEDULER_WORK
+    if( ( Scheduler->WorkQueue != NULL ) && ( Queue_isQueueEmpty( Scheduler->WorkQueue ) == FALSE ) )
+    {
+        pending = TRUE;
+    }
+#endif
+#ifdef SCHEDULER_MAILBOX
+    if( ( Scheduler->Inbox != NULL ) && ( Queue_isQueueEmpty( Scheduler->Inbox ) == FALSE ) )
+    {
+        pending = TRUE;
+    }
+#endif
+    return pending;
+}
+#endif
+
+/**
+ * @brief   **Stop decrementing the Timer Count**
  *
  * The function will stop the Timer decrement Count on each tick only if the Timer is registered,
  * This is the only mechanism to stop a Timer. The function only set the flag StartFlag to FALSE.
  *
  * @param   Scheduler  Scheduler control structure
  */
-STATIC void Inits_Dispatch( SchedulerType *Scheduler )
+STATIC void Timers_Dispatch( SchedulerType *Scheduler )
+{
+#ifdef SCHEDULER_PROFILING
+    uint32_t start;
+#endif
+#ifdef SCHEDULER_TIMER_LIST
+    TimerType *timer;
+    uint8_t id;
+
+    if( Scheduler->TimerList != 0u )
+    {
+        /*Only the first Timer in the list is decremented by one tick*/
+        timer        = &Scheduler->TimerPtr[ Scheduler->TimerList - 1u ];
+        timer->Count = ( timer->Count > Scheduler->Tick ) ? ( timer->Count - Scheduler->Tick ) : 0u;
+        /*Expire all the timers at the beginning of the list with nothing left*/
+        while( ( Scheduler->TimerList != 0u ) && ( Scheduler->TimerPtr[ Scheduler->TimerList - 1u ].Count == 0u ) )
+        {
+            id                   = Scheduler->TimerList;
+            timer                = &Scheduler->TimerPtr[ id - 1u ];
+            Scheduler->TimerList = timer->Next;
+            /*the reload keeps the phase but walks the list, each auto-reload expiration is O(n)*/
+            if( timer->AutoReload == TRUE )
+            {
+                Timer_Insert( Scheduler, id, timer->Timeout );
+            }
+            else
+            {
+                timer->StartFlag = FALSE;
+            }
+            /*If a callback was registered, run*/
+            if( timer->CallbackPtr != NULL )
+            {
+#ifdef SCHEDULER_PROFILING
+                start = Cycles_Get( );
+#endif
+                TRACE_EVENT( Scheduler, SCHEDULER_TRACE_TIMER_START, id );
+                timer->CallbackPtr( );
+                TRACE_EVENT( Scheduler, SCHEDULER_TRACE_TIMER_END, id );
+#ifdef SCHEDULER_PROFILING
+                Profile_Update( &timer->Profile, Cycles_Get( ) - start );
+#endif
+            }
+        }
+    }
+#else
+    for( uint8_t i = 0u; i < Scheduler->TimersCount; i++ )
+    {
+        /*Only run those Timer that are started*/
+        if( Scheduler->TimerPtr[ i ].StartFlag == TRUE )
+        {
+            /*Decrement Timer Count by one tick*/
+            Scheduler->TimerPtr[ i ].Count -= Scheduler->Tick;
+            /*If Timer reach Count to zero, deactivate or reload Timer*/
+            if( Scheduler->TimerPtr[ i ].Count == 0u )
+            {
+                if( Scheduler->TimerPtr[ i ].AutoReload == TRUE )
+                {
+                    Scheduler->TimerPtr[ i ].Count = Scheduler->TimerPtr[ i ].Timeout;
+                }
+                else
+                {
+                    Scheduler->TimerPtr[ i ].StartFlag = FALSE;
+                }
+                /*If a callback was registered, run*/
+                if( Scheduler->TimerPtr[ i ].CallbackPtr != NULL )
+                {
+#ifdef SCHEDULER_PROFILING
+                    start = Cycles_Get( );
+#endif
+                    TRACE_EVENT( Scheduler, SCHEDULER_TRACE_TIMER_START, i + 1u );
+                    Scheduler->TimerPtr[ i ].CallbackPtr( );
+                    TRACE_EVENT( Scheduler, SCHEDULER_TRACE_TIMER_END, i + 1u );
+#ifdef SCHEDULER_PROFILING
+                    Profile_Update( &Scheduler->TimerPtr[ i ].Profile, Cycles_Get( ) - start );
+#endif
+                }
+            }
+        }
+    }
+#endif
+}
+
+#ifdef SCHEDULER_LOAD
+/**
+ * @brief   **Clear a load period**
+ *
+ * @param   Meter   Load period to clear
+ * @param   Length  Number of cycles in the period
+ */
+STATIC void Load_Reset( LoadMeterType *Meter, uint32_t Length )
+{
+    Meter->Length  = Length;
+    Meter->Start   = 0u;
+    Meter->Busy    = 0u;
+    Meter->Peak    = 0u;
+    Meter->Load    = 0u;
+    Meter->MaxTick = 0u;
+    Meter->Idle    = 0u;
+}
+
+/**
+ * @brief   **Count busy cycles**
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Cycles     Cycles spent running something
+ */
+STATIC void Load_Busy( SchedulerType *Scheduler, uint32_t Cycles )
+{
+    Scheduler->LoadSecond.Busy += Cycles;
+    Scheduler->LoadWindow.Busy += Cycles;
+}
+
+/**
+ * @brief   **Count a tick dispatch**
+ *
+ * The cycles since the dispatch started are busy and the longest tick is kept, then the periods
+ * that have reached its length are completed.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Start      Cycle count when the dispatch started
+ */
+STATIC void Load_Tick( SchedulerType *Scheduler, uint32_t Start )
+{
+    uint32_t now  = Cycles_Get( );
+    uint32_t busy = now - Start;
+
+    Load_Busy( Scheduler, busy );
+    if( busy > Scheduler->LoadSecond.Peak )
+    {
+        Scheduler->LoadSecond.Peak = busy;
+    }
+    if( busy > Scheduler->LoadWindow.Peak )
+    {
+        Scheduler->LoadWindow.Peak = busy;
+    }
+
+    if( ( now - Scheduler->LoadSecond.Start ) >= Scheduler->LoadSecond.Length )
+    {
+        Load_Period( &Scheduler->LoadSecond, now, Scheduler->LoadSecond.Busy );
+    }
+    if( ( now - Scheduler->LoadWindow.Start ) >= Scheduler->LoadWindow.Length )
+    {
+        Load_Period( &Scheduler->LoadWindow, now, Scheduler->LoadWindow.Busy );
+    }
+}
+
+/**
+ * @brief   **Complete a load period**
+ *
+ * The results of the period are calculated and a new one starts.
+ *
+ * @param   Meter  Load period to complete
+ * @param   Now    Cycle count at the end of the period
+ * @param   Busy   Busy cycles of the period
+ */
+STATIC void Load_Period( LoadMeterType *Meter, uint32_t Now, uint32_t Busy )
+{
+    uint32_t elapsed = Now - Meter->Start;
+
+    /*the load can not go beyond 100% if the counter was read a little late*/
+    Meter->Load    = ( elapsed > Busy ) ? (uint16_t)( ( (uint64_t)Busy * 1000u ) / elapsed ) : 1000u;
+    Meter->Idle    = ( elapsed > Busy ) ? ( elapsed - Busy ) : 0u;
+    Meter->MaxTick = Meter->Peak;
+    Meter->Start   = Now;
+    Meter->Busy    = 0u;
+    Meter->Peak    = 0u;
+}
+#endif
+
+#ifdef SCHEDULER_TRACE
+/**
+ * @brief   **Log a trace record**
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Event      One of the SCHEDULER_TRACE_ values
+ * @param   Id         Task or Timer ID
+ */
+STATIC void Trace_Write( SchedulerType *Scheduler, uint8_t Event, uint8_t Id )
+{
+    TraceType record;
+
+    if( Scheduler->TraceQueue != NULL )
+    {
+        record.Stamp = Cycles_Get( );
+        record.Time  = (uint16_t)Scheduler->Time;
+        record.Event = Event;
+        record.Id    = Id;
+        (void)Queue_WriteData( Scheduler->TraceQueue, &record );
+    }
+}
+#endif
+
+#ifdef SCHEDULER_CYCLES
+/**
+ * @brief   **Enable the cycle counter**
+ *
+ * On cores with DWT the trace block is enabled and the cycle counter starts from zero, on cores
+ * without it the SysTick already configured by the HAL is used and there is nothing to do.
+ */
+STATIC void Cycles_Init( void )
+{
+#ifdef DWT_CTRL_CYCCNTENA_Msk
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT       = 0u;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * @brief   **Read the current cycle count**
+ *
+ * Without DWT the cycles are the HAL tick times the SysTick reload plus the cycles already
+ * counted down in the current millisecond, the tick is read twice to discard a read done while
+ * the SysTick was wrapping around.
+ *
+ * @retval  Free running count of CPU cycles, the difference of two reads is the time between them
+ */
+STATIC uint32_t Cycles_Get( void )
+{
+#ifdef DWT_CTRL_CYCCNTENA_Msk
+    return DWT->CYCCNT;
+#else
+    uint32_t tick;
+    uint32_t value;
+
+    do
+    {
+        tick  = HAL_GetTick( );
+        value = SysTick->VAL;
+    } while( tick != HAL_GetTick( ) );
+
+    return ( tick * ( SysTick->LOAD + 1u ) ) + ( SysTick->LOAD - value );
+#endif
+}
+#endif
+
+#ifdef SCHEDULER_PROFILING
+
+/**
+ * @brief   **Clear a profile**
+ *
+ * @param   Profile  Profile to clear
+ */
+STATIC void Profile_Reset( ProfileType *Profile )
+{
+    Profile->Min   = 0u;
+    Profile->Max   = 0u;
+    Profile->Total = 0u;
+    Profile->Runs  = 0u;
+}
+
+/**
+ * @brief   **Add one run to a profile**
+ *
+ * @param   Profile  Profile to update
+ * @param   Cycles   Number of cycles the run took
+ */
+STATIC void Profile_Update( ProfileType *Profile, uint32_t Cycles )
+{
+    if( ( Profile->Runs == 0u ) || ( Cycles < Profile->Min ) )
+    {
+        Profile->Min = Cycles;
+    }
+    if( Cycles > Profile->Max )
+    {
+        Profile->Max = Cycles;
+    }
+    Profile->Total += Cycles;
+    Profile->Runs++;
+}
+#endif
+
+#ifdef SCHEDULER_TICKLESS
+/**
+ * @brief   **Calculate the number of idle ticks**
+ *
+ * The function looks for the task or timer that is due first and returns the number of ticks
+ * with nothing to dispatch before it, a zero means something will be dispatched in the next tick
+ * like the tasks left in the ready list when the budget ran out
+ *
+ * @param   Scheduler  Scheduler control structure
+ *
+ * @retval  Number of ticks before the next dispatch with work, no more than SCHEDULER_IDLE_MAX
+ */
+STATIC uint32_t Ticks_Idle( SchedulerType *Scheduler )
+{
+    uint32_t idle = SCHEDULER_IDLE_MAX;
+    uint32_t ticks;
+
+    /*the task at the top of the heap is the next one to run*/
+    if( Scheduler->HeapCount > 0u )
+    {
+        ticks = 0u;
+        if( (int32_t)( Scheduler->TaskPtr[ Scheduler->TaskPtr[ 0u ].Heap ].Release - Scheduler->Time ) > 0 )
+        {
+            ticks = ( Scheduler->TaskPtr[ Scheduler->TaskPtr[ 0u ].Heap ].Release - Scheduler->Time ) / Scheduler->Tick;
+        }
+        idle = ( ticks < idle ) ? ticks : idle;
+    }
+
+#ifdef SCHEDULER_PRIORITY
+    /*the tasks deferred by the budget run on the next tick*/
+    if( Scheduler->ReadyList != 0u )
+    {
+        idle = 0u;
+    }
+#endif
+
+#ifdef SCHEDULER_TIMER_LIST
+    /*the first timer in the list is the next one to expire*/
+    if( Scheduler->TimerList != 0u )
+    {
+        ticks = ( Scheduler->TimerPtr[ Scheduler->TimerList - 1u ].Count / Scheduler->Tick ) - 1u;
+        idle  = ( ticks < idle ) ? ticks : idle;
+    }
+#else
+    for( uint8_t i = 0u; i < Scheduler->TimersCount; i++ )
+    {
+        if( Scheduler->TimerPtr[ i ].StartFlag == TRUE )
+        {
+            /*the timer expires in the tick its Count reach zero*/
+            ticks = ( Scheduler->TimerPtr[ i ].Count / Scheduler->Tick ) - 1u;
+            idle  = ( ticks < idle ) ? ticks : idle;
+        }
+    }
+#endif
+
+    return idle;
+}
+#endif
+
+/**
+ * @brief   **Credit ticks not dispatched**
+ *
+ * Advance the scheduler time and decrement the running timers as if the given number of
+ * ticks were dispatched, a timer never goes below one tick so it expires on the next dispatch.
+ * Used for the tickless idle ticks and for the missed ticks that are not dispatched.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Ticks      Number of ticks to credit
+ */
+STATIC void Ticks_Credit( SchedulerType *Scheduler, uint32_t Ticks )
+{
+    uint32_t time = Ticks * Scheduler->Tick;
+#ifdef SCHEDULER_TIMER_LIST
+    uint32_t elapsed = time;
+    uint32_t clamp = Scheduler->Tick;
+    uint8_t timer = Scheduler->TimerList;
+#endif
+
+    if( time > 0u )
+    {
+        /*the tasks release time is absolute, just move the time forward*/
+        Scheduler->Time += time;
+
+#ifdef SCHEDULER_TIMER_LIST
+        /*each timer is relative to the previous one, substract the time until it is used up*/
+        while( ( timer != 0u ) && ( elapsed > 0u ) )
+        {
+            if( Scheduler->TimerPtr[ timer - 1u ].Count > elapsed )
+            {
+                Scheduler->TimerPtr[ timer - 1u ].Count -= elapsed;
+                elapsed = 0u;
+            }
+            else
+            {
+                /*the first expired timer is left one tick away and the next expired ones with it*/
+                elapsed -= Scheduler->TimerPtr[ timer - 1u ].Count;
+                Scheduler->TimerPtr[ timer - 1u ].Count = clamp;
+                elapsed += clamp;
+                clamp    = 0u;
+            }
+            timer = Scheduler->TimerPtr[ timer - 1u ].Next;
+        }
+#else
+        for( uint8_t i = 0u; i < Scheduler->TimersCount; i++ )
+        {
+            if( Scheduler->TimerPtr[ i ].StartFlag == TRUE )
+            {
+                Scheduler->TimerPtr[ i ].Count = ( Scheduler->TimerPtr[ i ].Count > time ) ? ( Scheduler->TimerPtr[ i ].Count - time ) : Scheduler->Tick;
+            }
+        }
+#endif
+    }
+}
+
+/**
+ * @brief   **Apply the catch-up policy to the missed ticks**
+ *
+ * With #SCHEDULER_CATCHUP_ALL only the missed ticks beyond the limit are credited, the rest are
+ * left to be dispatched one after another, with the other policies all the missed ticks are
+ * credited. Each tick dispatched late or never dispatched counts as missed.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Ticks      Number of ticks behind besides the one about to be dispatched
+ *
+ * @retval  Number of ticks credited, the tick start shall be advanced by them
+ */
+STATIC uint32_t Ticks_Missed( SchedulerType *Scheduler, uint32_t Ticks )
 {
-    for( uint8_t i = 0u; i < Scheduler->TasksCount; i++ )
+    uint32_t drop = Ticks;
+
+    if( Ticks > 0u )
     {
-        /*Only run those init functions truly registered*/
-        if( Scheduler->TaskPtr[ i ].InitFunc != NULL )
+        if( Scheduler->Catchup == SCHEDULER_CATCHUP_ALL )
         {
-            /*Init registered Task*/
-            Scheduler->TaskPtr[ i ].InitFunc( );
+            drop = ( Ticks > Scheduler->CatchupLimit ) ? ( Ticks - Scheduler->CatchupLimit ) : 0u;
+            /*the tick about to be dispatched is late while there are ticks left behind*/
+            if( drop < Ticks )
+            {
+                Scheduler->Missed++;
+            }
         }
+        Scheduler->Missed += drop;
+        Ticks_Credit( Scheduler, drop );
     }
+
+    return drop;
 }
 
 /**
- * @brief   **Stop decrementing the Timer Count**
+ * @brief   **Compare two tasks in the heap**
  *
- * The function will stop the Timer decrement Count on each tick only if the Timer is registered,
- * This is the only mechanism to stop a Timer. The function only set the flag StartFlag to FALSE.
+ * @param   Scheduler  Scheduler control structure
+ * @param   A          Index of the first task
+ * @param   B          Index of the second task
+ *
+ * @retval  #TRUE if task A shall run before task B, tasks with the same release time run in
+ *          registration order, otherwise #FALSE
+ */
+STATIC uint8_t Task_Before( const SchedulerType *Scheduler, uint8_t A, uint8_t B )
+{
+    int32_t diff = (int32_t)( Scheduler->TaskPtr[ A ].Release - Scheduler->TaskPtr[ B ].Release );
+
+    return ( ( diff < 0 ) || ( ( diff == 0 ) && ( A < B ) ) ) ? TRUE : FALSE;
+}
+
+/**
+ * @brief   **Move a task up in the heap**
+ *
+ * Exchange the task with its parent while the task runs first
  *
  * @param   Scheduler  Scheduler control structure
+ * @param   Index      position of the task to move
  */
-STATIC void Tasks_Dispatch( SchedulerType *Scheduler )
+STATIC void Heap_Up( SchedulerType *Scheduler, uint32_t Index )
+{
+    uint32_t child = Index;
+    uint32_t parent;
+    uint8_t temp;
+
+    while( child > 0u )
+    {
+        parent = ( child - 1u ) / 2u;
+        /*stop when the parent already runs first*/
+        if( Task_Before( Scheduler, Scheduler->TaskPtr[ child ].Heap, Scheduler->TaskPtr[ parent ].Heap ) == FALSE )
+        {
+            break;
+        }
+        temp                              = Scheduler->TaskPtr[ child ].Heap;
+        Scheduler->TaskPtr[ child ].Heap  = Scheduler->TaskPtr[ parent ].Heap;
+        Scheduler->TaskPtr[ parent ].Heap = temp;
+        child                             = parent;
+    }
+}
+
+/**
+ * @brief   **Move a task down in the heap**
+ *
+ * Exchange the task with the child that runs first while the child runs before the task
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Index      position of the task to move
+ */
+STATIC void Heap_Down( SchedulerType *Scheduler, uint32_t Index )
+{
+    uint32_t parent = Index;
+    uint32_t child  = ( parent * 2u ) + 1u;
+    uint8_t temp;
+
+    while( child < Scheduler->HeapCount )
+    {
+        /*pick the child that runs first*/
+        if( ( ( child + 1u ) < Scheduler->HeapCount ) && ( Task_Before( Scheduler, Scheduler->TaskPtr[ child + 1u ].Heap, Scheduler->TaskPtr[ child ].Heap ) == TRUE ) )
+        {
+            child++;
+        }
+        /*stop when the parent already runs first*/
+        if( Task_Before( Scheduler, Scheduler->TaskPtr[ child ].Heap, Scheduler->TaskPtr[ parent ].Heap ) == FALSE )
+        {
+            break;
+        }
+        temp                              = Scheduler->TaskPtr[ child ].Heap;
+        Scheduler->TaskPtr[ child ].Heap  = Scheduler->TaskPtr[ parent ].Heap;
+        Scheduler->TaskPtr[ parent ].Heap = temp;
+        parent                            = child;
+        child                             = ( parent * 2u ) + 1u;
+    }
+}
+
+/**
+ * @brief   **Insert a task in the heap**
+ *
+ * Event tasks with no period are never released by time and they are not inserted
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task       The Task ID to insert, it shall not be already in the heap
+ */
+STATIC void Heap_Insert( SchedulerType *Scheduler, uint8_t Task )
+{
+#ifdef SCHEDULER_COROUTINE
+    /*a suspended coroutine is released by time even with no period*/
+    if( ( Scheduler->TaskPtr[ Task - 1u ].Period > 0u ) || ( Scheduler->TaskPtr[ Task - 1u ].Resume != 0u ) )
+#else
+    if( Scheduler->TaskPtr[ Task - 1u ].Period > 0u )
+#endif
+    {
+        Scheduler->TaskPtr[ Scheduler->HeapCount ].Heap = Task - 1u;
+        Scheduler->HeapCount++;
+        Heap_Up( Scheduler, (uint32_t)Scheduler->HeapCount - 1u );
+    }
+}
+
+/**
+ * @brief   **Remove a task from the heap**
+ *
+ * The task is searched in the heap and the last task in the heap takes its place, then that task
+ * is moved up or down to keep the heap order.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task       The Task ID to remove
+ *
+ * @retval  #TRUE if the task was in the heap otherwise #FALSE
+ */
+STATIC uint8_t Heap_Remove( SchedulerType *Scheduler, uint8_t Task )
+{
+    uint8_t found = FALSE;
+    uint32_t i = 0u;
+
+    while( ( i < Scheduler->HeapCount ) && ( Scheduler->TaskPtr[ i ].Heap != ( Task - 1u ) ) )
+    {
+        i++;
+    }
+
+    if( i < Scheduler->HeapCount )
+    {
+        Scheduler->HeapCount--;
+        Scheduler->TaskPtr[ i ].Heap = Scheduler->TaskPtr[ Scheduler->HeapCount ].Heap;
+        if( i < Scheduler->HeapCount )
+        {
+            Heap_Up( Scheduler, i );
+            Heap_Down( Scheduler, i );
+        }
+        found = TRUE;
+    }
+
+    return found;
+}
+
+/**
+ * @brief   **Insert again all the started tasks in the heap**
+ *
+ * @param   Scheduler  Scheduler control structure
+ */
+STATIC void Heap_Rebuild( SchedulerType *Scheduler )
 {
-    /*Scan all registered Task*/
+    Scheduler->HeapCount = 0u;
+
     for( uint8_t i = 0u; i < Scheduler->TasksCount; i++ )
     {
-        /*Only run those tasks that are started*/
         if( Scheduler->TaskPtr[ i ].StartFlag == TRUE )
         {
-            /*Only run those tasks that already has its Elapsed time*/
-            if( Scheduler->TaskPtr[ i ].Elapsed >= Scheduler->TaskPtr[ i ].Period )
+            Heap_Insert( Scheduler, i + 1u );
+        }
+    }
+}
+
+#ifdef SCHEDULER_COROUTINE
+/**
+ * @brief   **Place a coroutine task after it runs**
+ *
+ * A task suspended by this run keeps its periodic release as pending and it is released again
+ * once the ticks to sleep have passed, one tick if it just yield. A task that was suspended and
+ * reaches the end of its job takes back the pending release, a late one is handled by the
+ * dispatcher like any other late task.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task       The Task ID that just ran
+ * @param   Resumed    Resume point the task had before running, zero if it was not suspended
+ */
+STATIC void Coroutine_Schedule( SchedulerType *Scheduler, uint8_t Task, uint16_t Resumed )
+{
+    TaskType *task = &Scheduler->TaskPtr[ Task - 1u ];
+    /*the dispatched tick, the scheduler time is already the next one*/
+    uint32_t now = Scheduler->Time - Scheduler->Tick;
+
+    if( ( task->Resume != 0u ) || ( Resumed != 0u ) )
+    {
+        (void)Heap_Remove( Scheduler, Task );
+        if( task->Resume != 0u )
+        {
+            if( Resumed == 0u )
             {
-                Scheduler->TaskPtr[ i ].Elapsed = 0u;
-                /*Run Task*/
-                Scheduler->TaskPtr[ i ].TaskFunc( );
+                task->Pending = task->Release;
             }
+            task->Release = now + ( Scheduler->Tick * ( ( task->Sleep > 0u ) ? task->Sleep : 1u ) );
+            task->Sleep   = 0u;
+        }
+        else
+        {
+            task->Release = task->Pending;
+        }
+        /*a finished event task is not inserted*/
+        if( task->StartFlag == TRUE )
+        {
+            Heap_Insert( Scheduler, Task );
         }
-        /*Increment the Task Elapsed time in ticks*/
-        Scheduler->TaskPtr[ i ].Elapsed += Scheduler->Tick;
     }
 }
+#endif
 
 /**
- * @brief   **Stop decrementing the Timer Count**
+ * @brief   **Next task to stagger**
  *
- * The function will stop the Timer decrement Count on each tick only if the Timer is registered,
- * This is the only mechanism to stop a Timer. The function only set the flag StartFlag to FALSE.
+ * The periodic tasks are visited by Period and then by ID, the next one is the task with the
+ * smallest Period and ID after the given task.
  *
  * @param   Scheduler  Scheduler control structure
+ * @param   Task       The last Task ID visited, zero to get the first one
+ *
+ * @retval  The next Task ID or zero if there are no more tasks
  */
-STATIC void Timers_Dispatch( SchedulerType *Scheduler )
+STATIC uint8_t Stagger_Next( const SchedulerType *Scheduler, uint8_t Task )
 {
-    for( uint8_t i = 0u; i < Scheduler->TimersCount; i++ )
+    uint8_t next = 0u;
+    uint32_t period;
+
+    for( uint8_t i = 0u; i < Scheduler->TasksCount; i++ )
     {
-        /*Only run those Timer that are started*/
-        if( Scheduler->TimerPtr[ i ].StartFlag == TRUE )
+        period = Scheduler->TaskPtr[ i ].Period;
+        /*only the periodic tasks after the last one visited*/
+        if( ( period > 0u ) && ( ( Task == 0u ) || ( period > Scheduler->TaskPtr[ Task - 1u ].Period ) ||
+            ( ( period == Scheduler->TaskPtr[ Task - 1u ].Period ) && ( i >= Task ) ) ) )
         {
-            /*Decrement Timer Count by one tick*/
-            Scheduler->TimerPtr[ i ].Count -= Scheduler->Tick;
-            /*If Timer reach Count to zero, deactivate Timer*/
-            if( Scheduler->TimerPtr[ i ].Count == 0u )
+            /*keep the smallest, the first found wins a tie*/
+            if( ( next == 0u ) || ( period < Scheduler->TaskPtr[ next - 1u ].Period ) )
             {
-                Scheduler->TimerPtr[ i ].StartFlag = FALSE;
-                /*If a callback was registered, run*/
-                if( Scheduler->TimerPtr[ i ].CallbackPtr != NULL )
-                {
-                    Scheduler->TimerPtr[ i ].CallbackPtr( );
-                }
+                next = i + 1u;
+            }
+        }
+    }
+
+    return next;
+}
+
+/**
+ * @brief   **Number of tasks released together with a task**
+ *
+ * Count the tasks already placed by Scheduler_StaggerTasks that at some point are released on the
+ * same tick as the Task would be with the given offset.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task       The Task ID to place
+ * @param   Offset     Candidate offset for the Task
+ *
+ * @retval  Number of tasks placed that collide with the Task
+ */
+STATIC uint32_t Stagger_Cost( const SchedulerType *Scheduler, uint8_t Task, uint32_t Offset )
+{
+    uint32_t cost = 0u;
+    uint32_t period = Scheduler->TaskPtr[ Task - 1u ].Period;
+    uint32_t offset;
+    uint32_t diff;
+    uint32_t other;
+
+    for( uint8_t i = 0u; i < Scheduler->TasksCount; i++ )
+    {
+        other = Scheduler->TaskPtr[ i ].Period;
+        /*the tasks placed are the ones visited before this one, by Period and then by ID*/
+        if( ( other > 0u ) && ( ( other < period ) || ( ( other == period ) && ( i < ( Task - 1u ) ) ) ) )
+        {
+            offset = Scheduler->TaskPtr[ i ].Release - Scheduler->Time;
+            diff   = ( Offset > offset ) ? ( Offset - offset ) : ( offset - Offset );
+            if( ( diff % Period_Gcd( period, other ) ) == 0u )
+            {
+                cost++;
             }
         }
     }
+
+    return cost;
+}
+
+/**
+ * @brief   **Greatest common divisor of two periods**
+ *
+ * @param   A  First period, different from zero
+ * @param   B  Second period, different from zero
+ *
+ * @retval  The greatest common divisor
+ */
+STATIC uint32_t Period_Gcd( uint32_t A, uint32_t B )
+{
+    uint32_t a = A;
+    uint32_t b = B;
+    uint32_t r;
+
+    while( b != 0u )
+    {
+        r = a % b;
+        a = b;
+        b = r;
+    }
+
+    return a;
+}
+
+#ifdef SCHEDULER_PRIORITY
+/**
+ * @brief   **Compare two ready tasks**
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   A          Index of the first task
+ * @param   B          Index of the second task
+ *
+ * @retval  #TRUE if task A shall run before task B according to the selected order, tasks with
+ *          the same key run in registration order, otherwise #FALSE
+ */
+STATIC uint8_t Ready_Before( const SchedulerType *Scheduler, uint8_t A, uint8_t B )
+{
+    const TaskType *a = &Scheduler->TaskPtr[ A ];
+    const TaskType *b = &Scheduler->TaskPtr[ B ];
+    int32_t diff;
+
+    if( Scheduler->Order == SCHEDULER_ORDER_RM )
+    {
+        diff = ( a->Period < b->Period ) ? -1 : ( ( a->Period > b->Period ) ? 1 : 0 );
+    }
+    else if( Scheduler->Order == SCHEDULER_ORDER_EDF )
+    {
+        /*the deadline of a ready task is its next release*/
+        diff = (int32_t)( a->Release - b->Release );
+    }
+    else
+    {
+        diff = (int32_t)a->Priority - (int32_t)b->Priority;
+    }
+
+    return ( ( diff < 0 ) || ( ( diff == 0 ) && ( A < B ) ) ) ? TRUE : FALSE;
+}
+
+/**
+ * @brief   **Insert a task in the ready list**
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task       The Task ID to insert, it shall not be already in the list
+ */
+STATIC void Ready_Insert( SchedulerType *Scheduler, uint8_t Task )
+{
+    uint8_t *link = &Scheduler->ReadyList;
+
+    /*skip the tasks that run before*/
+    while( ( *link != 0u ) && ( Ready_Before( Scheduler, *link - 1u, Task - 1u ) == TRUE ) )
+    {
+        link = &Scheduler->TaskPtr[ *link - 1u ].Next;
+    }
+
+    Scheduler->TaskPtr[ Task - 1u ].Next = *link;
+    *link                                = Task;
+}
+
+/**
+ * @brief   **Remove a task from the ready list**
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Task       The Task ID to remove
+ *
+ * @retval  #TRUE if the task was in the list otherwise #FALSE
+ */
+STATIC uint8_t Ready_Remove( SchedulerType *Scheduler, uint8_t Task )
+{
+    uint8_t found = FALSE;
+    uint8_t *link = &Scheduler->ReadyList;
+
+    /*look for the link pointing to the task*/
+    while( ( *link != 0u ) && ( *link != Task ) )
+    {
+        link = &Scheduler->TaskPtr[ *link - 1u ].Next;
+    }
+
+    if( *link == Task )
+    {
+        *link = Scheduler->TaskPtr[ Task - 1u ].Next;
+        found = TRUE;
+    }
+
+    return found;
+}
+#endif
+
+#ifdef SCHEDULER_TIMER_LIST
+/**
+ * @brief   **Insert a timer in the list of running timers**
+ *
+ * The list is walked substracting the time of each timer until finding one that expires later,
+ * the new timer is placed before it and that timer becomes relative to the new one. Timers that
+ * expire at the same time keep the registration order.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer      The Timer ID to insert, it shall not be already in the list
+ * @param   Time       Time left for the timer to expire
+ */
+STATIC void Timer_Insert( SchedulerType *Scheduler, uint8_t Timer, uint32_t Time )
+{
+    uint32_t time = Time;
+    uint8_t *link = &Scheduler->TimerList;
+
+    /*skip the timers that expire before, or at the same time with a lower ID*/
+    while( ( *link != 0u ) && ( ( time > Scheduler->TimerPtr[ *link - 1u ].Count ) ||
+           ( ( time == Scheduler->TimerPtr[ *link - 1u ].Count ) && ( *link < Timer ) ) ) )
+    {
+        time -= Scheduler->TimerPtr[ *link - 1u ].Count;
+        link  = &Scheduler->TimerPtr[ *link - 1u ].Next;
+    }
+
+    /*the following timer is now relative to the new one*/
+    if( *link != 0u )
+    {
+        Scheduler->TimerPtr[ *link - 1u ].Count -= time;
+    }
+
+    Scheduler->TimerPtr[ Timer - 1u ].Count = time;
+    Scheduler->TimerPtr[ Timer - 1u ].Next  = *link;
+    *link                                   = Timer;
+}
+
+/**
+ * @brief   **Remove a timer from the list of running timers**
+ *
+ * The time left of the removed timer is added to the following one so the rest of the list keeps
+ * the same expiration times.
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer      The Timer ID to remove, it shall be in the list
+ *
+ * @retval  The time left for the removed timer to expire
+ */
+STATIC uint32_t Timer_Remove( SchedulerType *Scheduler, uint8_t Timer )
+{
+    uint32_t time = 0u;
+    uint8_t *link = &Scheduler->TimerList;
+    TimerType *timer = &Scheduler->TimerPtr[ Timer - 1u ];
+
+    /*look for the link pointing to the timer*/
+    while( ( *link != 0u ) && ( *link != Timer ) )
+    {
+        time += Scheduler->TimerPtr[ *link - 1u ].Count;
+        link  = &Scheduler->TimerPtr[ *link - 1u ].Next;
+    }
+
+    if( *link == Timer )
+    {
+        time += timer->Count;
+        *link = timer->Next;
+        /*the following timer inherits the time of the removed one*/
+        if( timer->Next != 0u )
+        {
+            Scheduler->TimerPtr[ timer->Next - 1u ].Count += timer->Count;
+        }
+    }
+
+    return time;
+}
+
+/**
+ * @brief   **Time left of a running timer**
+ *
+ * @param   Scheduler  Scheduler control structure
+ * @param   Timer      The Timer ID, it shall be in the list
+ *
+ * @retval  The sum of the timer Count and the Count of all the timers before it in the list
+ */
+STATIC uint32_t Timer_Remaining( SchedulerType *Scheduler, uint8_t Timer )
+{
+    uint32_t time = 0u;
+    uint8_t timer = Scheduler->TimerList;
+
+    while( ( timer != 0u ) && ( timer != Timer ) )
+    {
+        time += Scheduler->TimerPtr[ timer - 1u ].Count;
+        timer = Scheduler->TimerPtr[ timer - 1u ].Next;
+    }
+
+    if( timer == Timer )
+    {
+        time += Scheduler->TimerPtr[ timer - 1u ].Count;
+    }
+
+    return time;
 }
+#endif
@@ -10,15 +10,213 @@
  *
  * Software timers are an optional resource that can be use with the scheduler, each timer
  * shall be register previous use, and those will decrement on each tick until reaching zero,
- * after that the timer will stop and can be re-started.
+ * after that the timer will stop and can be re-started, or it is reloaded with its timeout and
+ * keeps running if the auto-reload mode was set with Scheduler_AutoReloadTimer.
  *
  * The systick timer is used trough the HAL_SysTick functions as a means of the tick counter
- * it is not advice to modify the default configuration that runs the tick each milliseconds
+ * it is not advice to modify the default configuration that runs the tick each milliseconds,
+ * each scheduler instance can take its milliseconds from a different source set with
+ * Scheduler_SetTickSource, for instance one scheduler per core on dual core parts.
+ *
+ * The started tasks are kept in a min-heap ordered by its next release time, so on each tick
+ * only the tasks that are due are touched no matter how many tasks are registered, tasks due at
+ * the same time still run in registration order.
+ *
+ * By default all the tasks are released on the first tick, Scheduler_OffsetTask delays the first
+ * release of a task and Scheduler_StaggerTasks selects the offsets of all the tasks so the ones
+ * with related periods do not run on the same ticks, flattening the load of each tick.
+ *
+ * A task can also be notified from an interrupt with Scheduler_NotifyTask, the task will run on the
+ * next scheduler pass without waiting for its period, a task registered with a zero period only
+ * runs when it is notified (event task).
+ *
+ * Defining SCHEDULER_COROUTINE at compile time a task can be written as a coroutine that returns
+ * in the middle of its job and continues from the same point on a later tick, using the
+ * SCHEDULER_TASK_ macros, so long jobs are split in steps without writing a state machine.
+ *
+ * Defining SCHEDULER_WORK at compile time an interrupt can post a function and a context word
+ * with Scheduler_PostWork to run at task level on the next pass of the scheduler (bottom half),
+ * the work waits in a static queue set with Scheduler_InitWork so the interrupt just copies it.
+ *
+ * Defining SCHEDULER_MAILBOX at compile time two scheduler instances, usually one on each core,
+ * can post work to each other through a pair of queues in shared memory, Scheduler_PostRemote
+ * writes into the outbox and rings a doorbell function that interrupts the other core, the other
+ * scheduler runs the work from its inbox on its next pass. On cores with data cache, like the M7
+ * of the STM32H7, the mailbox queues and its buffers shall be placed in memory not cached by the
+ * linker script or set as shared non-cacheable with the MPU, the barrier of the queue orders the
+ * writes but does not push them out of the cache of one core to the other.
+ *
+ * Defining SCHEDULER_TRACE at compile time the scheduler logs a small record with the cycle count
+ * each time a tick starts and each time a task, timer callback or init function starts and ends,
+ * the records go to a queue set with Scheduler_InitTrace that keeps the newest ones, the queue can
+ * be read with the queue functions to send it by UART or with Scheduler_FlushTraceItm over SWO,
+ * tools/trace_decode.py turns the records into a timeline.
+ *
+ * Defining SCHEDULER_PRIORITY at compile time the tasks due on the same tick run ordered by its
+ * priority, by its period (rate monotonic) or by its next release time (earliest deadline first)
+ * instead of the registration order, also a budget of CPU cycles per tick can be set so the
+ * lower priority tasks are deferred to the next tick instead of making the tick overrun.
+ *
+ * The scheduler tick advances exactly one Tick each time so lateness does not accumulate, when a
+ * dispatch takes longer than a tick the ticks missed are handled according to the catch-up policy
+ * set with Scheduler_SetCatchup, by default all the missed ticks are dispatched one after another.
+ *
+ * Defining SCHEDULER_TICKLESS at compile time the scheduler will not spin waiting for the next
+ * tick, instead it calculates how many ticks there are until the next task or timer is due and
+ * calls Scheduler_IdleHook with the time to sleep, the default hook just executes a WFI but the
+ * application can provide its own to enter a deeper low power mode.
+ *
+ * Defining SCHEDULER_TIMER_LIST at compile time the running timers are kept in a list sorted by
+ * expiration time where each timer stores only the time left after the previous one, this way on
+ * each tick only the first timer needs to be decremented no matter how many timers are running.
+ * The price is paid when a timer is placed in the list, starting, reloading or auto-reloading a
+ * timer walks the list up to its new position, so each auto-reload expiration costs O(n) instead
+ * of the O(1) reload of the array. The list pays off with many running timers of which only a few
+ * expire on each tick, like long timeouts or one-shot timers, while many short auto-reload timers
+ * expiring on every tick are cheaper with the default array that costs O(n) per tick.
+ *
+ * Defining SCHEDULER_PROFILING at compile time each task and timer callback run is measured in CPU
+ * cycles using the DWT cycle counter, or the SysTick counter on cores without DWT like the M0+, the
+ * minimum, maximum, total and number of runs are kept and the ticks where the whole dispatch took
+ * longer than the scheduler tick are counted as overruns.
+ *
+ * Defining SCHEDULER_LOAD at compile time the scheduler measures the CPU cycles spent running the
+ * tick dispatches, notified tasks and posted work, Scheduler_GetLoad reports the load of the last
+ * second and of the last window set with Scheduler_SetLoadWindow, the longest tick and the idle time.
  *
  */
 #ifndef SCHEDULER_H_
 #define SCHEDULER_H_
 
+#if defined( SCHEDULER_WORK ) || defined( SCHEDULER_TRACE ) || defined( SCHEDULER_MAILBOX )
+#include "queue.h"
+#endif
+
+/**
+  * @defgroup Catch-up policies for the ticks missed while a dispatch took longer than the tick
+  @{ */
+#define SCHEDULER_CATCHUP_ALL   0u  /*!< dispatch each missed tick, up to a limit, one after another */
+#define SCHEDULER_CATCHUP_ONCE  1u  /*!< late tasks and timers run once, the missed releases are lost */
+#define SCHEDULER_CATCHUP_SKIP  2u  /*!< late tasks wait for its next release without running */
+/**
+  @} */
+
+/**
+  * @defgroup Order to run the tasks due on the same tick with SCHEDULER_PRIORITY
+  @{ */
+#define SCHEDULER_ORDER_PRIORITY  0u  /*!< lower Priority value first, zero is the highest */
+#define SCHEDULER_ORDER_RM        1u  /*!< shorter Period first (rate monotonic) */
+#define SCHEDULER_ORDER_EDF       2u  /*!< earlier next release first (earliest deadline first) */
+/**
+  @} */
+
+#ifdef SCHEDULER_COROUTINE
+/**
+  * @defgroup Coroutine tasks, the macros are used inside the task function with the scheduler
+  * running the task, the body of the task goes between SCHEDULER_TASK_BEGIN and SCHEDULER_TASK_END.
+  * The local variables are not kept when the task returns, so the ones used after a yield shall be
+  * static and the task body cannot use a switch statement with a yield inside.
+  @{ */
+#define SCHEDULER_TASK_BEGIN( Scheduler )    switch( (Scheduler)->Running->Resume ) { case 0u: /*!< start or resume the task */
+#define SCHEDULER_TASK_END( Scheduler )      } (Scheduler)->Running->Resume = 0u /*!< the job is done, next run starts over */
+#define SCHEDULER_TASK_YIELD( Scheduler )                                                          \
+    do { (Scheduler)->Running->Resume = (uint16_t)__LINE__; return; case __LINE__: ; } while( 0 ) /*!< continue on the next tick */
+#define SCHEDULER_TASK_SLEEP( Scheduler, Ticks )                                                   \
+    do { (Scheduler)->Running->Sleep = (Ticks); SCHEDULER_TASK_YIELD( Scheduler ); } while( 0 ) /*!< continue after Ticks ticks */
+#define SCHEDULER_TASK_WAIT_UNTIL( Scheduler, Condition )                                          \
+    while( !( Condition ) ) { SCHEDULER_TASK_YIELD( Scheduler ); } /*!< check again each tick */
+/**
+  @} */
+#endif
+
+/**
+  * @defgroup Trace events logged with SCHEDULER_TRACE, the Id is the task or timer ID
+  @{ */
+#define SCHEDULER_TRACE_TICK         0u  /*!< a tick dispatch starts, Id is zero */
+#define SCHEDULER_TRACE_TASK_START   1u  /*!< a task function starts */
+#define SCHEDULER_TRACE_TASK_END     2u  /*!< a task function returns */
+#define SCHEDULER_TRACE_TIMER_START  3u  /*!< a timer callback starts */
+#define SCHEDULER_TRACE_TIMER_END    4u  /*!< a timer callback returns */
+#define SCHEDULER_TRACE_INIT_START   5u  /*!< a task init function starts */
+#define SCHEDULER_TRACE_INIT_END     6u  /*!< a task init function returns */
+/**
+  @} */
+
+#ifdef SCHEDULER_LOAD
+/**
+ * @brief   Load measurement period
+ *
+ * Cycles counted over a measurement period and the results of the last period completed
+ */
+typedef struct _LoadMeterType
+{
+    uint32_t Length;        /*!< number of cycles in the period*/
+    uint32_t Start;         /*!< cycle count when the period started*/
+    uint32_t Busy;          /*!< busy cycles so far in the period*/
+    uint32_t Peak;          /*!< busy cycles of the longest tick so far in the period*/
+    uint16_t Load;          /*!< busy time of the last period in tenths of percent*/
+    uint32_t MaxTick;       /*!< busy cycles of the longest tick of the last period*/
+    uint32_t Idle;          /*!< idle cycles of the last period*/
+} LoadMeterType;
+
+/**
+ * @brief   CPU load
+ *
+ * Load of the last periods completed, the cycles can be converted to time with SystemCoreClock
+ */
+typedef struct _LoadType
+{
+    uint16_t Second;        /*!< load of the last second in tenths of percent*/
+    uint16_t Window;        /*!< load of the last window in tenths of percent*/
+    uint32_t Peak;          /*!< busy cycles of the longest tick in the last window*/
+    uint32_t Idle;          /*!< idle cycles in the last window*/
+} LoadType;
+#endif
+
+#ifdef SCHEDULER_TRACE
+/**
+ * @brief   Trace record
+ *
+ * Eight bytes record with no padding, it is stored and sent as it is in little endian
+ */
+typedef struct _TraceType
+{
+    uint32_t Stamp;         /*!< CPU cycle count when the event took place*/
+    uint16_t Time;          /*!< lower 16 bits of the scheduler time in ms, tasks see the next tick*/
+    uint8_t Event;          /*!< one of the SCHEDULER_TRACE_ values*/
+    uint8_t Id;             /*!< task or timer ID*/
+} TraceType;
+#endif
+
+#if defined( SCHEDULER_WORK ) || defined( SCHEDULER_MAILBOX )
+/**
+ * @brief   Deferred work item
+ *
+ * Function posted from an interrupt or the other core to run later at task level, the context is
+ * passed to it
+ */
+typedef struct _WorkType
+{
+    void (*Func)(uint32_t Context); /*!< function to run*/
+    uint32_t Context;               /*!< value to pass to the function*/
+} WorkType;
+#endif
+
+#ifdef SCHEDULER_PROFILING
+/**
+ * @brief   Execution time profile
+ *
+ * Execution time measured in CPU cycles for a task or a timer callback, the average is Total / Runs
+ */
+typedef struct _ProfileType
+{
+    uint32_t Min;           /*!< shortest run in cycles*/
+    uint32_t Max;           /*!< longest run in cycles*/
+    uint64_t Total;         /*!< sum of the cycles of all runs*/
+    uint32_t Runs;          /*!< number of runs measured*/
+} ProfileType;
+#endif
+
 /**
  * @brief   Task Control Block definition
  *
@@ -28,10 +226,24 @@
 typedef struct _TaskType 
 {
     uint32_t Period;          /*How often the task shopud run in ms*/
-    uint32_t Elapsed;         /*the cuurent elapsed time*/
+    uint32_t Release;         /*scheduler time in ms when the task shall run again*/
     uint8_t StartFlag;        /*flag to run task*/
+    uint8_t Heap;             /*task index stored at this position of the release heap*/
+    volatile uint8_t Notified;/*flag set by Scheduler_NotifyTask to run the task on the next pass*/
+#ifdef SCHEDULER_PRIORITY
+    uint8_t Priority;         /*task priority, zero is the highest*/
+    uint8_t Next;             /*next ready task ID, zero for the last one*/
+#endif
+#ifdef SCHEDULER_COROUTINE
+    uint16_t Resume;          /*point to continue the coroutine, zero when it is not suspended*/
+    uint32_t Sleep;           /*ticks to wait before continue, set by SCHEDULER_TASK_SLEEP*/
+    uint32_t Pending;         /*periodic release time to keep while the coroutine is suspended*/
+#endif
     void (*InitFunc)(void);   /*pointer to init task function*/
     void (*TaskFunc)(void);   /*pointer to task function*/
+#ifdef SCHEDULER_PROFILING
+    ProfileType Profile;      /*execution time of the task function*/
+#endif
 } TaskType;
 
 /**
@@ -43,9 +255,16 @@ typedef struct _TaskType
 typedef struct _TimerType
 {
     uint32_t Timeout;       /*!< timer timeout to decrement and reload when the timer is re-started */
-    uint8_t Count;         /*!< actual timer decrement count */
+    uint32_t Count;        /*!< actual timer decrement count */
     uint8_t StartFlag;     /*!< flag to start timer count */
+    uint8_t AutoReload;    /*!< flag to reload the timer with its timeout when it expires */
     void(*CallbackPtr)(void);  /*!< pointer to callback function function */
+#ifdef SCHEDULER_TIMER_LIST
+    uint8_t Next;          /*!< next running timer ID in the list, zero for the last one */
+#endif
+#ifdef SCHEDULER_PROFILING
+    ProfileType Profile;   /*!< execution time of the callback function */
+#endif
 } TimerType;
 
 /**
@@ -61,24 +280,107 @@ typedef struct _SchedulerType
     uint32_t Timeout;       /*!< the number of milliseconds the scheduler should run*/
     uint8_t TasksCount;     /*!< internal task counter*/
     TaskType *TaskPtr;      /*!< Pointer to buffer for the TCB tasks*/
+    uint32_t Time;          /*!< scheduler time in ms of the next dispatch*/
+    uint8_t HeapCount;      /*!< number of started tasks in the release heap*/
+    uint8_t Catchup;        /*!< policy for the missed ticks*/
+    uint32_t CatchupLimit;  /*!< maximum number of missed ticks to dispatch with SCHEDULER_CATCHUP_ALL*/
+    uint32_t Missed;        /*!< number of ticks not dispatched on time*/
+    volatile uint8_t Notified; /*!< flag set when any task has been notified*/
+#ifdef SCHEDULER_PRIORITY
+    uint8_t Order;          /*!< order to run the ready tasks, one of SCHEDULER_ORDER_ values*/
+    uint8_t ReadyList;      /*!< first task ID ready to run, zero if no task is waiting*/
+    uint32_t Budget;        /*!< CPU cycles per tick to run ready tasks, zero for no limit*/
+#endif
+#ifdef SCHEDULER_WORK
+    QueueType *WorkQueue;   /*!< queue with the work posted from interrupts, NULL if not set*/
+#endif
+#ifdef SCHEDULER_MAILBOX
+    QueueType *Inbox;       /*!< queue written by the other instance, NULL if not set*/
+    QueueType *Outbox;      /*!< queue read by the other instance, NULL if not set*/
+    void (*Doorbell)(void); /*!< function to interrupt the other core after posting, NULL for none*/
+#endif
+#ifdef SCHEDULER_TRACE
+    QueueType *TraceQueue;  /*!< queue to log the trace records, NULL if not set*/
+#endif
+#ifdef SCHEDULER_COROUTINE
+    TaskType *Running;      /*!< task running at the moment, used by the SCHEDULER_TASK_ macros*/
+#endif
     uint8_t Timers;         /*number of software timer to use*/
     TimerType *TimerPtr;    /*Pointer to buffer timer array*/
     uint8_t TimersCount;    /*!< internal timer counter*/
+    uint32_t (*GetTick)(void); /*!< milliseconds counter of this instance, HAL_GetTick by default*/
+#ifdef SCHEDULER_TIMER_LIST
+    uint8_t TimerList;      /*!< first running timer ID in the list, zero if no timer is running*/
+#endif
+#ifdef SCHEDULER_PROFILING
+    uint32_t TickCycles;    /*!< number of CPU cycles in one tick*/
+    uint32_t Overruns;      /*!< number of ticks where the dispatch took longer than the tick*/
+#endif
+#ifdef SCHEDULER_LOAD
+    LoadMeterType LoadSecond; /*!< load measured over one second*/
+    LoadMeterType LoadWindow; /*!< load measured over the window set by the application*/
+#endif
 } SchedulerType;
 
 
 void Scheduler_Init( SchedulerType *Scheduler, uint32_t TickBase, uint8_t Tasks, TaskType *TasksBuffer, uint8_t Timers, TimerType *TimerBuffer );
 void Scheduler_MainFunction( SchedulerType *Scheduler );
+uint8_t Scheduler_SetCatchup( SchedulerType *Scheduler, uint8_t Policy, uint32_t Limit );
+uint32_t Scheduler_GetMissedTicks( SchedulerType *Scheduler );
+void Scheduler_SetTickSource( SchedulerType *Scheduler, uint32_t (*GetTick)(void) );
 
 uint8_t Scheduler_RegisterTask( SchedulerType *Scheduler, void (*InitPtr)(void), void (*TaskPtr)(void), uint32_t Period );
 uint8_t Scheduler_StopTask( SchedulerType *Scheduler, uint8_t Task );
 uint8_t Scheduler_StartTask( SchedulerType *Scheduler, uint8_t Task );
 uint8_t Scheduler_PeriodTask( SchedulerType *Scheduler, uint8_t Task, uint32_t Period );
+uint8_t Scheduler_NotifyTask( SchedulerType *Scheduler, uint8_t Task );
+uint8_t Scheduler_OffsetTask( SchedulerType *Scheduler, uint8_t Task, uint32_t Offset );
+void Scheduler_StaggerTasks( SchedulerType *Scheduler );
 
 uint8_t Scheduler_RegisterTimer( SchedulerType *Scheduler, uint32_t Timeout, void (*CallbackPtr)(void) );
 uint32_t Scheduler_GetTimer( SchedulerType *Scheduler, uint8_t Timer );
 uint8_t Scheduler_ReloadTimer( SchedulerType *Scheduler, uint8_t Timer, uint32_t Timeout );
 uint8_t Scheduler_StartTimer( SchedulerType *Scheduler, uint8_t Timer );
 uint8_t Scheduler_StopTimer( SchedulerType *Scheduler, uint8_t Timer );
+uint8_t Scheduler_AutoReloadTimer( SchedulerType *Scheduler, uint8_t Timer, uint8_t AutoReload );
+
+#ifdef SCHEDULER_TICKLESS
+void Scheduler_IdleHook( uint32_t Time );
+#endif
+
+#ifdef SCHEDULER_WORK
+void Scheduler_InitWork( SchedulerType *Scheduler, QueueType *Queue, WorkType *Buffer, uint32_t Elements );
+uint8_t Scheduler_PostWork( SchedulerType *Scheduler, void (*Func)(uint32_t Context), uint32_t Context );
+#endif
+
+#ifdef SCHEDULER_MAILBOX
+void Scheduler_InitMailbox( QueueType *Mailbox, WorkType *Buffer, uint32_t Elements );
+void Scheduler_SetMailbox( SchedulerType *Scheduler, QueueType *Inbox, QueueType *Outbox, void (*Doorbell)(void) );
+uint8_t Scheduler_PostRemote( SchedulerType *Scheduler, void (*Func)(uint32_t Context), uint32_t Context );
+#endif
+
+#ifdef SCHEDULER_TRACE
+void Scheduler_InitTrace( SchedulerType *Scheduler, QueueType *Queue, TraceType *Buffer, uint32_t Elements );
+#ifdef SCHEDULER_TRACE_ITM
+uint32_t Scheduler_FlushTraceItm( SchedulerType *Scheduler );
+#endif
+#endif
+
+#ifdef SCHEDULER_PRIORITY
+uint8_t Scheduler_PriorityTask( SchedulerType *Scheduler, uint8_t Task, uint8_t Priority );
+uint8_t Scheduler_SetOrder( SchedulerType *Scheduler, uint8_t Order );
+void Scheduler_SetBudget( SchedulerType *Scheduler, uint32_t Cycles );
+#endif
+
+#ifdef SCHEDULER_PROFILING
+uint8_t Scheduler_GetTaskProfile( SchedulerType *Scheduler, uint8_t Task, ProfileType *Profile );
+uint8_t Scheduler_GetTimerProfile( SchedulerType *Scheduler, uint8_t Timer, ProfileType *Profile );
+uint32_t Scheduler_GetOverruns( SchedulerType *Scheduler );
+#endif
+
+#ifdef SCHEDULER_LOAD
+uint8_t Scheduler_SetLoadWindow( SchedulerType *Scheduler, uint32_t Window );
+void Scheduler_GetLoad( SchedulerType *Scheduler, LoadType *Load );
+#endif
 
 #endif
\ No newline at end of file
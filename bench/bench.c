@@ -0,0 +1,382 @@
+/**
+ * @file    bench.c
+ * @brief   **Benchmark of the queue, scheduler, buttons and keypad modules**
+ *
+ * Measure the cost of the hot paths of each module so the optimizations can be compared with
+ * numbers, the queue write and read throughput for several element sizes, the cost of one tick
+ * of Tasks_Dispatch and Timers_Dispatch as the number of tasks and timers grows, and the cost of
+ * Buttons_MainFunction per button and of one Keypad_MainFunction scan.
+ *
+ * On the host the time is measured in nanoseconds with the monotonic clock and the HAL is the
+ * mock bsp.h in this folder, build it with the Makefile. Defining BENCH_TARGET the same code runs
+ * on the microcontroller measuring CPU cycles with the DWT cycle counter, or the SysTick on cores
+ * without it, the application calls Bench_Run with printf retargeted to a UART or semihosting and
+ * the modules shall be built with UTEST so the scheduler dispatchers are visible.
+ */
+#ifndef BENCH_TARGET
+#define _POSIX_C_SOURCE 199309L /*!< clock_gettime from time.h in strict C99 */
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include "bsp.h"
+#include "queue.h"
+#include "scheduler.h"
+#include "buttons.h"
+#include "keypad.h"
+
+#ifndef BENCH_TARGET
+#include <time.h>
+#endif
+
+#define TRUE 1u /*!< TRUE definition */
+
+/**
+  * @defgroup Benchmark sizes, they can be reduced from the command line for small targets
+  @{ */
+#ifndef BENCH_REPEATS
+#define BENCH_REPEATS   10000u  /*!< ticks or operations measured on each case */
+#endif
+#define BENCH_QUEUE     256u    /*!< elements of the power of two queue */
+#define BENCH_QUEUE_ODD 250u    /*!< elements of the queue that is not a power of two */
+#define BENCH_BURST     128u    /*!< elements written and then read on each round */
+#define BENCH_ELEMENT   64u     /*!< largest element size in bytes */
+#define BENCH_TASKS     250u    /*!< largest number of tasks and timers */
+#define BENCH_BUTTONS   64u     /*!< largest number of buttons */
+/**
+  @} */
+
+#ifdef BENCH_TARGET
+#define BENCH_UNIT  "cycles" /*!< unit of the values reported */
+#else
+#define BENCH_UNIT  "ns"     /*!< unit of the values reported */
+GPIO_TypeDef BenchPorts[ 6 ];
+EXTI_TypeDef BenchExti;
+SysTick_Type BenchSysTick;
+#ifdef BENCH_DWT
+DWT_Type BenchDwt;
+CoreDebug_Type BenchCoreDebug;
+#endif
+ITM_Type BenchItm;
+volatile uint32_t BenchTick;
+uint32_t SystemCoreClock = 64000000u;
+#endif
+
+void Tasks_Dispatch( SchedulerType *Scheduler );
+void Timers_Dispatch( SchedulerType *Scheduler );
+void Bench_Run( void );
+
+static void Bench_Init( void );
+static uint32_t Bench_Now( void );
+static void Bench_Report( const char *Name, uint32_t Count, uint32_t Elapsed, uint32_t Ops );
+static void Bench_Queue( void );
+static void Bench_Tasks( void );
+static void Bench_Timers( void );
+static void Bench_Buttons( void );
+static void Bench_Keypad( void );
+static void Bench_Nothing( void );
+
+static uint8_t QueueBuffer[ BENCH_QUEUE * BENCH_ELEMENT ];
+static uint8_t Element[ BENCH_ELEMENT ];
+static TaskType Tasks[ BENCH_TASKS ];
+static TimerType Timers[ BENCH_TASKS ];
+static ButtonType ButtonsBuffer[ BENCH_BUTTONS ];
+static volatile uint32_t Runs;
+
+#ifndef BENCH_TARGET
+/**
+ * @brief   **Host entry point**
+ */
+int main( void )
+{
+    Bench_Run( );
+    return 0;
+}
+#endif
+
+/**
+ * @brief   **Run all the benchmarks**
+ *
+ * Each line reports the case, the size of the case and the average cost of one operation
+ */
+void Bench_Run( void )
+{
+    Bench_Init( );
+    printf( "%-28s %6s %12s\n", "case", "n", BENCH_UNIT "/op" );
+    Bench_Queue( );
+    Bench_Tasks( );
+    Bench_Timers( );
+    Bench_Buttons( );
+    Bench_Keypad( );
+}
+
+/**
+ * @brief   **Queue write and read throughput**
+ *
+ * A burst of elements is written and then read back, with a power of two queue initialized with
+ * Queue_InitPow2 that wraps around with a mask and with a queue of any size initialized with
+ * Queue_Init that wraps around with a compare, one operation is one write plus one read.
+ */
+static void Bench_Queue( void )
+{
+    static const uint8_t sizes[] = { 1u, 4u, 16u, 64u };
+    static const uint32_t elements[] = { BENCH_QUEUE, BENCH_QUEUE_ODD };
+    static const char *names[] = { "queue write+read pow2", "queue write+read" };
+    QueueType queue;
+    uint32_t start;
+    uint32_t elapsed;
+    uint32_t rounds = BENCH_REPEATS / BENCH_BURST;
+
+    for( uint32_t e = 0u; e < 2u; e++ )
+    {
+        for( uint32_t s = 0u; s < sizeof( sizes ); s++ )
+        {
+            if( e == 0u )
+            {
+                (void)Queue_InitPow2( &queue, QueueBuffer, elements[ e ], sizes[ s ] );
+            }
+            else
+            {
+                Queue_Init( &queue, QueueBuffer, elements[ e ], sizes[ s ] );
+            }
+            start = Bench_Now( );
+            for( uint32_t r = 0u; r < rounds; r++ )
+            {
+                for( uint32_t i = 0u; i < BENCH_BURST; i++ )
+                {
+                    (void)Queue_WriteData( &queue, Element );
+                }
+                for( uint32_t i = 0u; i < BENCH_BURST; i++ )
+                {
+                    (void)Queue_ReadData( &queue, Element );
+                }
+            }
+            elapsed = Bench_Now( ) - start;
+            Bench_Report( names[ e ], sizes[ s ], elapsed, rounds * BENCH_BURST );
+        }
+    }
+}
+
+/**
+ * @brief   **Cost of one tick of Tasks_Dispatch**
+ *
+ * The tasks have periods from 1 to 16 ms and an empty body, so the cost is the dispatcher itself
+ */
+static void Bench_Tasks( void )
+{
+    static const uint8_t counts[] = { 1u, 8u, 32u, 128u, BENCH_TASKS };
+    SchedulerType scheduler;
+    uint32_t start;
+    uint32_t elapsed;
+
+    for( uint32_t c = 0u; c < sizeof( counts ); c++ )
+    {
+        Scheduler_Init( &scheduler, 1u, counts[ c ], Tasks, 0u, NULL );
+        for( uint32_t i = 0u; i < counts[ c ]; i++ )
+        {
+            (void)Scheduler_RegisterTask( &scheduler, NULL, Bench_Nothing, 1u << ( i % 5u ) );
+        }
+        start = Bench_Now( );
+        for( uint32_t r = 0u; r < BENCH_REPEATS; r++ )
+        {
+            Tasks_Dispatch( &scheduler );
+        }
+        elapsed = Bench_Now( ) - start;
+        Bench_Report( "Tasks_Dispatch per tick", counts[ c ], elapsed, BENCH_REPEATS );
+    }
+}
+
+/**
+ * @brief   **Cost of one tick of Timers_Dispatch**
+ *
+ * The timers are auto-reload with timeouts from 1 to 16 ms and an empty callback
+ */
+static void Bench_Timers( void )
+{
+    static const uint8_t counts[] = { 1u, 8u, 32u, 128u, BENCH_TASKS };
+    SchedulerType scheduler;
+    uint32_t start;
+    uint32_t elapsed;
+    uint8_t timer;
+
+    for( uint32_t c = 0u; c < sizeof( counts ); c++ )
+    {
+        Scheduler_Init( &scheduler, 1u, 0u, Tasks, counts[ c ], Timers );
+        for( uint32_t i = 0u; i < counts[ c ]; i++ )
+        {
+            timer = Scheduler_RegisterTimer( &scheduler, ( i % 16u ) + 1u, Bench_Nothing );
+            (void)Scheduler_AutoReloadTimer( &scheduler, timer, TRUE );
+            (void)Scheduler_StartTimer( &scheduler, timer );
+        }
+        start = Bench_Now( );
+        for( uint32_t r = 0u; r < BENCH_REPEATS; r++ )
+        {
+            Timers_Dispatch( &scheduler );
+        }
+        elapsed = Bench_Now( ) - start;
+        Bench_Report( "Timers_Dispatch per tick", counts[ c ], elapsed, BENCH_REPEATS );
+    }
+}
+
+/**
+ * @brief   **Cost of Buttons_MainFunction per button**
+ *
+ * On the host the buttons are spread over the six ports and the inputs flip every 20 samples so
+ * the buttons go through all the states, one operation is one button sampled once. With
+ * BUTTONS_WAKEUP each flip also wakes up the buttons as the EXTI interrupt would, otherwise the
+ * sampling stops once the buttons are idle and only the sleep check is measured.
+ */
+static void Bench_Buttons( void )
+{
+    static const uint8_t counts[] = { 1u, 8u, 16u, BENCH_BUTTONS };
+    KeyboardType keyboard;
+    uint32_t start;
+    uint32_t elapsed;
+
+    for( uint32_t c = 0u; c < sizeof( counts ); c++ )
+    {
+        Buttons_Init( &keyboard, counts[ c ], 5u, ButtonsBuffer );
+        for( uint32_t i = 0u; i < counts[ c ]; i++ )
+        {
+            (void)Buttons_Register( &keyboard, i % 16u, i / 16u, 1u );
+        }
+        start = Bench_Now( );
+        for( uint32_t r = 0u; r < BENCH_REPEATS; r++ )
+        {
+#ifndef BENCH_TARGET
+            if( ( r % 20u ) == 0u )
+            {
+                for( uint32_t p = 0u; p < 6u; p++ )
+                {
+                    BenchPorts[ p ].IDR ^= 0xFFFFu;
+                }
+#ifdef BUTTONS_WAKEUP
+                Buttons_Wakeup( &keyboard );
+#endif
+            }
+#endif
+            Buttons_MainFunction( &keyboard );
+        }
+        elapsed = Bench_Now( ) - start;
+        Bench_Report( "Buttons_MainFunction/button", counts[ c ], elapsed, BENCH_REPEATS * counts[ c ] );
+    }
+}
+
+/**
+ * @brief   **Cost of one scan of Keypad_MainFunction**
+ *
+ * Square matrices with the rows on port A and the columns on port B, on the host the columns
+ * flip every 20 scans so the keys go through presses and releases.
+ */
+static void Bench_Keypad( void )
+{
+    static const uint8_t sizes[] = { 4u, 8u };
+    static const uint8_t pins[] = { 0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u };
+    static KeypadType keypad;
+    uint32_t start;
+    uint32_t elapsed;
+
+    for( uint32_t c = 0u; c < sizeof( sizes ); c++ )
+    {
+        Keypad_Init( &keypad, sizes[ c ], sizes[ c ], 5u );
+        (void)Keypad_SetRows( &keypad, 0u, pins );
+        (void)Keypad_SetColumns( &keypad, 1u, 0u );
+        start = Bench_Now( );
+        for( uint32_t r = 0u; r < BENCH_REPEATS; r++ )
+        {
+#ifndef BENCH_TARGET
+            if( ( r % 20u ) == 0u )
+            {
+                BenchPorts[ 1 ].IDR ^= 0x0001u;
+            }
+#endif
+            Keypad_MainFunction( &keypad );
+        }
+        elapsed = Bench_Now( ) - start;
+        Bench_Report( "Keypad_MainFunction per scan", (uint32_t)sizes[ c ] * sizes[ c ], elapsed, BENCH_REPEATS );
+    }
+}
+
+/**
+ * @brief   **Print one result**
+ *
+ * @param   Name     Case measured
+ * @param   Count    Size of the case, elements size, number of tasks, timers or buttons
+ * @param   Elapsed  Time or cycles of the whole case
+ * @param   Ops      Number of operations in the case
+ */
+static void Bench_Report( const char *Name, uint32_t Count, uint32_t Elapsed, uint32_t Ops )
+{
+    printf( "%-28s %6lu %12.1f\n", Name, (unsigned long)Count, (double)Elapsed / (double)Ops );
+}
+
+/**
+ * @brief   **Empty task and callback**
+ */
+static void Bench_Nothing( void )
+{
+    Runs++;
+}
+
+#ifdef BENCH_TARGET
+/**
+ * @brief   **Start the cycle counter**
+ */
+static void Bench_Init( void )
+{
+#ifdef DWT_CTRL_CYCCNTENA_Msk
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT       = 0u;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * @brief   **Read the cycle counter**
+ *
+ * On cores without DWT the SysTick value is combined with the HAL tick like the scheduler does
+ * for profiling.
+ *
+ * @retval  Free running count of CPU cycles
+ */
+static uint32_t Bench_Now( void )
+{
+#ifdef DWT_CTRL_CYCCNTENA_Msk
+    return DWT->CYCCNT;
+#else
+    uint32_t tick;
+    uint32_t value;
+
+    do
+    {
+        tick  = HAL_GetTick( );
+        value = SysTick->VAL;
+    } while( tick != HAL_GetTick( ) );
+
+    return ( tick * ( SysTick->LOAD + 1u ) ) + ( SysTick->LOAD - value );
+#endif
+}
+#else
+/**
+ * @brief   **Nothing to start on the host**
+ */
+static void Bench_Init( void )
+{
+    BenchTick = 0u;
+    /*the scheduler cycle counter sees a 1 ms SysTick at the mock core clock*/
+    BenchSysTick.LOAD = ( SystemCoreClock / 1000u ) - 1u;
+    BenchSysTick.VAL  = BenchSysTick.LOAD;
+}
+
+/**
+ * @brief   **Read the host monotonic clock**
+ *
+ * @retval  Free running count of nanoseconds, the differences fit in 32 bits for a few seconds
+ */
+static uint32_t Bench_Now( void )
+{
+    struct timespec now;
+
+    (void)clock_gettime( CLOCK_MONOTONIC, &now );
+    return (uint32_t)( ( (uint64_t)now.tv_sec * 1000000000u ) + (uint64_t)now.tv_nsec );
+}
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file    bsp.h
+ * @brief   **Host mock of the board support package**
+ *
+ * Just the symbols the modules take from the HAL and CMSIS so they can be built and measured on
+ * the host, the tick, the GPIO input registers and the core timers are plain variables driven by
+ * the benchmark. The core is a Cortex-M0+ like the STM32G0 family, so the scheduler cycle counter
+ * runs on the SysTick, defining BENCH_DWT adds the DWT cycle counter of the Cortex-M3 and up.
+ * When the benchmark is built for the target with BENCH_TARGET this file shall not be in the
+ * include path so the real bsp.h is used instead.
+ */
+#ifndef BSP_H_
+#define BSP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief   GPIO registers, the modules read the input data register and the keypad drives its rows
+ */
+typedef struct _GPIO_TypeDef
+{
+    volatile uint32_t IDR;  /*!< input data register */
+    volatile uint32_t ODR;  /*!< output data register */
+    volatile uint32_t BSRR; /*!< bit set and reset register */
+} GPIO_TypeDef;
+
+/**
+ * @brief   EXTI registers of the STM32G0 family used to wake up the buttons
+ */
+typedef struct _EXTI_TypeDef
+{
+    volatile uint32_t RTSR1;        /*!< rising trigger selection */
+    volatile uint32_t FTSR1;        /*!< falling trigger selection */
+    volatile uint32_t RPR1;         /*!< rising edge pending */
+    volatile uint32_t FPR1;         /*!< falling edge pending */
+    volatile uint32_t EXTICR[ 4 ];  /*!< port selection of each line */
+    volatile uint32_t IMR1;         /*!< interrupt mask */
+} EXTI_TypeDef;
+
+/**
+ * @brief   SysTick registers, the scheduler reads the reload and the current value for profiling
+ */
+typedef struct _SysTick_Type
+{
+    volatile uint32_t CTRL;     /*!< control and status */
+    volatile uint32_t LOAD;     /*!< reload value */
+    volatile uint32_t VAL;      /*!< current value, counts down */
+    volatile uint32_t CALIB;    /*!< calibration value */
+} SysTick_Type;
+
+#ifdef BENCH_DWT
+/**
+ * @brief   DWT registers, only the control and the cycle counter
+ */
+typedef struct _DWT_Type
+{
+    volatile uint32_t CTRL;     /*!< control */
+    volatile uint32_t CYCCNT;   /*!< cycle counter */
+} DWT_Type;
+
+/**
+ * @brief   Core debug registers, only the exception and monitor control
+ */
+typedef struct _CoreDebug_Type
+{
+    volatile uint32_t DEMCR;    /*!< debug exception and monitor control */
+} CoreDebug_Type;
+#endif
+
+/**
+ * @brief   ITM stimulus port
+ */
+typedef union _ITM_Port
+{
+    volatile uint8_t u8;        /*!< 8-bit write */
+    volatile uint16_t u16;      /*!< 16-bit write */
+    volatile uint32_t u32;      /*!< 32-bit write, reads 1 when the port is ready */
+} ITM_Port;
+
+/**
+ * @brief   ITM registers, the trace is flushed only when enabled so the mock keeps it disabled
+ */
+typedef struct _ITM_Type
+{
+    ITM_Port PORT[ 32 ];        /*!< stimulus ports */
+    volatile uint32_t TER;      /*!< trace enable */
+    volatile uint32_t TCR;      /*!< trace control */
+} ITM_Type;
+
+extern GPIO_TypeDef BenchPorts[ 6 ];
+extern EXTI_TypeDef BenchExti;
+extern SysTick_Type BenchSysTick;
+#ifdef BENCH_DWT
+extern DWT_Type BenchDwt;
+extern CoreDebug_Type BenchCoreDebug;
+#endif
+extern ITM_Type BenchItm;
+extern volatile uint32_t BenchTick;
+extern uint32_t SystemCoreClock;
+
+/**
+  * @defgroup GPIO ports of the STM32G0 family mapped to the mock registers
+  @{ */
+#define GPIOA   ( &BenchPorts[ 0 ] ) /*!< port A */
+#define GPIOB   ( &BenchPorts[ 1 ] ) /*!< port B */
+#define GPIOC   ( &BenchPorts[ 2 ] ) /*!< port C */
+#define GPIOD   ( &BenchPorts[ 3 ] ) /*!< port D */
+#define GPIOE   ( &BenchPorts[ 4 ] ) /*!< port E */
+#define GPIOF   ( &BenchPorts[ 5 ] ) /*!< port F */
+#define EXTI    ( &BenchExti )       /*!< external interrupts controller */
+/**
+  @} */
+
+/**
+  * @defgroup Core peripherals mapped to the mock registers
+  @{ */
+#define SysTick ( &BenchSysTick )    /*!< system timer */
+#define ITM     ( &BenchItm )        /*!< instrumentation trace macrocell */
+#define ITM_TCR_ITMENA_Msk  ( 1ul << 0u ) /*!< ITM enable */
+#ifdef BENCH_DWT
+#define DWT         ( &BenchDwt )       /*!< data watchpoint and trace */
+#define CoreDebug   ( &BenchCoreDebug ) /*!< core debug */
+#define DWT_CTRL_CYCCNTENA_Msk      ( 1ul << 0u )  /*!< cycle counter enable */
+#define CoreDebug_DEMCR_TRCENA_Msk  ( 1ul << 24u ) /*!< trace enable */
+#endif
+/**
+  @} */
+
+#define __weak  __attribute__( ( weak ) ) /*!< weak symbol as defined by CMSIS */
+
+/**
+ * @brief   Simulated milliseconds counter
+ */
+static inline uint32_t HAL_GetTick( void )
+{
+    return BenchTick;
+}
+
+/**
+ * @brief   Read one pin of the mock input register
+ */
+static inline uint8_t HAL_GPIO_ReadPin( GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin )
+{
+    return ( ( GPIOx->IDR & GPIO_Pin ) != 0u ) ? 1u : 0u;
+}
+
+/**
+  * @defgroup Core intrinsics, the host has no interrupts to mask nor a sleep mode
+  @{ */
+static inline void __WFI( void ) { }
+static inline void __disable_irq( void ) { }
+static inline void __enable_irq( void ) { }
+static inline uint32_t __get_PRIMASK( void ) { return 0u; }
+static inline void __set_PRIMASK( uint32_t Mask ) { (void)Mask; }
+/**
+  @} */
+
+#endif
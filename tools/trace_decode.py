@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Decode the scheduler trace records into a timeline.
+
+The input is the raw stream of eight bytes records logged with SCHEDULER_TRACE, as copied from the
+trace queue over UART, or a SWO capture written by Scheduler_FlushTraceItm when --itm is given.
+Each record is stamp (uint32), time (uint16), event (uint8) and id (uint8) in little endian.
+
+Usage:
+    trace_decode.py trace.bin --clock 64000000 [--tick 1] [--itm] [--summary]
+"""
+import argparse
+import struct
+import sys
+
+EVENTS = {
+    0: "TICK",
+    1: "TASK_START",
+    2: "TASK_END",
+    3: "TIMER_START",
+    4: "TIMER_END",
+    5: "INIT_START",
+    6: "INIT_END",
+}
+
+#start event of each end event
+STARTS = {2: 1, 4: 3, 6: 5}
+
+RECORD = struct.Struct("<IHBB")
+
+
+def itm_payload(data):
+    """Strip the ITM protocol headers keeping the payload written to stimulus port 0"""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        header = data[i]
+        if header & 0x03:
+            #source packet, software ones have bit 2 clear and the port number in the upper five bits
+            size = {1: 1, 2: 2, 3: 4}[header & 0x03]
+            if (header & 0x04) == 0 and (header >> 3) == 0:
+                out += data[i + 1:i + 1 + size]
+            i += 1 + size
+        elif header in (0x00, 0x80, 0x70):
+            #sync bytes and overflow
+            i += 1
+        elif header & 0x80:
+            #timestamp or extension packet, the continuation bit is set on each byte but the last
+            i += 1
+            while i < len(data) and data[i] & 0x80:
+                i += 1
+            i += 1
+        else:
+            #single byte timestamp or extension
+            i += 1
+    return bytes(out)
+
+
+def records(data):
+    """Yield the records unwrapping the 32-bit cycle counter"""
+    wraps = 0
+    last = None
+    for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        stamp, time, event, ident = RECORD.unpack_from(data, offset)
+        if last is not None and stamp < last:
+            wraps += 1
+        last = stamp
+        yield (wraps << 32) + stamp, time, event, ident
+
+
+def name(event, ident):
+    kind = EVENTS.get(event, "EVENT_%d" % event)
+    return kind if event == 0 else "%s %d" % (kind, ident)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("file", help="binary trace file, - for stdin")
+    parser.add_argument("--clock", type=float, default=0.0, help="core clock in Hz to print microseconds")
+    parser.add_argument("--tick", type=float, default=0.0, help="scheduler tick in ms to flag overruns")
+    parser.add_argument("--itm", action="store_true", help="input is a SWO capture with ITM headers")
+    parser.add_argument("--summary", action="store_true", help="print only the per tick summary")
+    args = parser.parse_args()
+
+    data = sys.stdin.buffer.read() if args.file == "-" else open(args.file, "rb").read()
+    if args.itm:
+        data = itm_payload(data)
+
+    def span(cycles):
+        return "%10.1f us" % (cycles * 1e6 / args.clock) if args.clock else "%10d cy" % cycles
+
+    first = None
+    open_ = {}
+    tick = None
+    ticks = []
+    for stamp, time, event, ident in records(data):
+        if first is None:
+            first = stamp
+        #the records are shown with the time of the tick they belong to
+        line = "%s  %5d ms  %-16s" % (span(stamp - first), tick[0] if (tick and event) else time, name(event, ident))
+        if event == 0:
+            if tick is not None:
+                ticks.append((tick[0], tick[2] - tick[1]))
+            tick = [time, stamp, stamp]
+        else:
+            if event in STARTS:
+                start = open_.pop((STARTS[event], ident), None)
+                if start is not None:
+                    line += "  took %s" % span(stamp - start).strip()
+            else:
+                open_[(event, ident)] = stamp
+            if tick is not None:
+                tick[2] = stamp
+        if not args.summary:
+            print(line)
+    if tick is not None:
+        ticks.append((tick[0], tick[2] - tick[1]))
+
+    #busy time of a tick goes from its start to the last record before the next tick
+    if ticks:
+        limit = args.tick * args.clock / 1000.0 if (args.tick and args.clock) else 0
+        print("\n%-8s %s" % ("tick ms", "busy"))
+        worst = 0
+        for time, busy in ticks:
+            worst = max(worst, busy)
+            flag = "  OVERRUN" if limit and busy > limit else ""
+            if args.summary or flag:
+                print("%-8d %s%s" % (time, span(busy).strip(), flag))
+        print("ticks %d, worst %s" % (len(ticks), span(worst).strip()))
+
+
+if __name__ == "__main__":
+    main()